@@ -0,0 +1,26 @@
+if(LIBTCC_INSTALL_DIR)
+  message(STATUS "Using override LIBTCC_INSTALL_DIR to find libtcc")
+  set(LIBTCC_INCLUDE_DIR "${LIBTCC_INSTALL_DIR}/include")
+  find_library(LIBTCC_LIBRARIES NAMES tcc PATHS "${LIBTCC_INSTALL_DIR}/lib" "${LIBTCC_INSTALL_DIR}/lib/tcc")
+else(LIBTCC_INSTALL_DIR)
+  find_path(LIBTCC_INCLUDE_DIR libtcc.h)
+  find_library(LIBTCC_LIBRARIES NAMES tcc)
+endif(LIBTCC_INSTALL_DIR)
+
+if(LIBTCC_INCLUDE_DIR AND LIBTCC_LIBRARIES)
+  set(LIBTCC_FOUND 1)
+  set(LIBTCC_INCLUDE_DIRS ${LIBTCC_INCLUDE_DIR})
+endif(LIBTCC_INCLUDE_DIR AND LIBTCC_LIBRARIES)
+
+if(LIBTCC_FOUND)
+  message(STATUS "Found libtcc: -L ${LIBTCC_LIBRARIES} -I ${LIBTCC_INCLUDE_DIRS}")
+else(LIBTCC_FOUND)
+  if(LIBTCC_FIND_REQUIRED)
+    message(FATAL_ERROR "Could NOT find libtcc" )
+  else(LIBTCC_FIND_REQUIRED)
+    message(STATUS "Could NOT find libtcc")
+  endif(LIBTCC_FIND_REQUIRED)
+endif(LIBTCC_FOUND)
+
+# Hide advanced variables from CMake GUIs
+mark_as_advanced(LIBTCC_INCLUDE_DIR LIBTCC_INCLUDE_DIRS LIBTCC_LIBRARIES)
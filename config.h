@@ -0,0 +1,30 @@
+/*
+ * config.h.in - Copyright (c) 2015 Jan de Visser <jan@finiandarcy.com>
+ *
+ * This file is part of Obelix.
+ *
+ * Obelix is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Obelix is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Obelix.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define OBELIX_NAME                          "Obelix"
+#define OBELIX_VERSION_MAJOR                 "2"
+#define OBELIX_VERSION_MINOR                 "0"
+#define OBELIX_VERSION                       "2.0"
+#define OBELIX_DIR                           "/tmp/obuild"
+#define OBELIX_DATADIR                       "/tmp/obuild/share"
+
+#define OBELIX_TRACE 1
+#define OBELIX_LIBTCC 0
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Obelix {
+
+// Identifies a version of a file by its resolved path, size and modification
+// time. These change whenever the file is rebuilt or replaced, and are much
+// cheaper to get than a hash of its contents.
+inline std::optional<std::string> file_stamp(std::filesystem::path const& path)
+{
+    std::error_code ec;
+    auto resolved = std::filesystem::canonical(path, ec);
+    if (ec)
+        return {};
+    auto size = std::filesystem::file_size(resolved, ec);
+    if (ec)
+        return {};
+    auto modified = std::filesystem::last_write_time(resolved, ec);
+    if (ec)
+        return {};
+    return resolved.string() + " " + std::to_string(size) + " " + std::to_string(modified.time_since_epoch().count());
+}
+
+// Marks a cache entry as used, so that trim_cache keeps it around longer.
+inline void touch_cache_entry(std::filesystem::path const& entry)
+{
+    std::error_code ec;
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), ec);
+}
+
+// Removes the least recently used entries of a cache directory until at
+// most max_entries are left.
+inline void trim_cache(std::filesystem::path const& cache_dir, size_t max_entries)
+{
+    std::error_code ec;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> entries;
+    for (auto const& entry : std::filesystem::directory_iterator(cache_dir, ec)) {
+        if (!entry.is_regular_file(ec))
+            continue;
+        entries.emplace_back(entry.last_write_time(ec), entry.path());
+    }
+    if (entries.size() <= max_entries)
+        return;
+    std::sort(entries.begin(), entries.end());
+    for (auto ix = 0u; ix < entries.size() - max_entries; ++ix)
+        std::filesystem::remove(entries[ix].second, ec);
+}
+
+}
@@ -6,6 +6,7 @@
 
 #include <filesystem>
 #include <iostream>
+#include <thread>
 
 #include <core/Logging.h>
 #include <obelix/Config.h>
@@ -18,6 +19,7 @@ namespace fs = std::filesystem;
 
 Config::Config(int argc, char const** argv)
 {
+    jobs = std::max(std::thread::hardware_concurrency(), 1u);
     for (int ix = 1; ix < argc; ++ix) {
         if ((strlen(argv[ix]) > 2) && !strncmp(argv[ix], "--", 2)) {
             if (auto eq_ptr = strchr(argv[ix], '='); eq_ptr == nullptr) {
@@ -61,6 +63,15 @@ Config::Config(int argc, char const** argv)
                 exit(-1);
             }
             target = target_maybe.value();
+        } else if (!strncmp(argv[ix], "--jobs", strlen("--jobs")) && (argv[ix][strlen("--jobs")] == '=')) {
+            char const* jobs_str = argv[ix] + strlen("--jobs=");
+            char* end_ptr;
+            auto num_jobs = strtol(jobs_str, &end_ptr, 10);
+            if ((*jobs_str == '\0') || (*end_ptr != '\0') || (num_jobs < 1)) {
+                std::cerr << "ERROR: Invalid number of jobs '" << jobs_str << "'\n";
+                exit(-1);
+            }
+            jobs = static_cast<unsigned int>(num_jobs);
         } else if (!strncmp(argv[ix], "--obelix-dir", strlen("--obelix-dir")) && (argv[ix][strlen("--obelix-dir")] == '=')) {
             obelix_dir = argv[ix] + strlen("--obelix-dir=");
         } else if (strncmp(argv[ix], "--", 2) && filename.empty()) {
@@ -31,6 +31,7 @@ public:
     bool materialize { true };
     bool compile { true };
     bool run { false };
+    unsigned int jobs { 1 };
 
     template <typename T>
     T cmdline_flag(std::string const& flag, T const& default_value = T()) const
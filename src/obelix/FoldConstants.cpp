@@ -76,7 +76,7 @@ NODE_PROCESSOR(BoundIntrinsicCall)
         auto processed = TRY_AND_CAST(BoundExpression, arg, ctx);
         processed_args.push_back(processed);
     }
-    result = std::make_shared<BoundIntrinsicCall>(call, processed_args, std::dynamic_pointer_cast<BoundIntrinsicDecl>(call->declaration()));
+    result = make_node<BoundIntrinsicCall>(call, processed_args, std::dynamic_pointer_cast<BoundIntrinsicDecl>(call->declaration()));
     interpret(result);
     return result.value();
 }
@@ -117,7 +117,7 @@ NODE_PROCESSOR(BoundBinaryExpression)
             std::shared_ptr<BoundExpression> new_lhs = make_node<BoundBinaryExpression>(lhs->location(), lhs, expr->op(), rhs_expr->lhs(), expr->type());
             new_lhs = TRY_AND_CAST(BoundExpression, interpret(new_lhs));
             if (std::dynamic_pointer_cast<BoundLiteral>(new_lhs) != nullptr) {
-                return std::make_shared<BoundBinaryExpression>(expr->location(),
+                return make_node<BoundBinaryExpression>(expr->location(),
                     new_lhs,
                     rhs_expr->op(),
                     rhs_expr->rhs(),
@@ -133,7 +133,7 @@ NODE_PROCESSOR(BoundBinaryExpression)
             std::shared_ptr<BoundExpression> new_rhs = make_node<BoundBinaryExpression>(rhs->location(), lhs_expr->rhs(), expr->op(), rhs, expr->type());
             new_rhs = TRY_AND_CAST(BoundExpression, interpret(new_rhs));
             if (std::dynamic_pointer_cast<BoundLiteral>(new_rhs) != nullptr) {
-                return std::make_shared<BoundBinaryExpression>(expr->location(),
+                return make_node<BoundBinaryExpression>(expr->location(),
                     lhs_expr->lhs(),
                     lhs_expr->op(),
                     new_rhs,
@@ -160,11 +160,11 @@ NODE_PROCESSOR(BoundBranch)
     auto branch = std::dynamic_pointer_cast<BoundBranch>(tree);
     auto cond = branch->condition();
     if (auto switch_expr = ctx.data().last_switch_expression(); switch_expr != nullptr && cond != nullptr) {
-        cond = std::make_shared<BoundBinaryExpression>(branch->location(), switch_expr, BinaryOperator::Equals, branch->condition(), ObjectType::get(PrimitiveType::Boolean));
+        cond = make_node<BoundBinaryExpression>(branch->location(), switch_expr, BinaryOperator::Equals, branch->condition(), ObjectType::get(PrimitiveType::Boolean));
     }
     auto stmt = TRY_AND_CAST(Statement, branch->statement(), ctx);
     if (cond == nullptr)
-        return std::make_shared<BoundBranch>(branch->location(), nullptr, stmt);
+        return make_node<BoundBranch>(branch->location(), nullptr, stmt);
     cond = TRY_AND_CAST(BoundExpression, cond, ctx);
 
     auto cond_literal = std::dynamic_pointer_cast<BoundBooleanLiteral>(cond);
@@ -177,7 +177,7 @@ NODE_PROCESSOR(BoundBranch)
         }
     }
     cond = TRY_AND_CAST(BoundExpression, branch->condition(), ctx);
-    return std::make_shared<BoundBranch>(branch->location(), cond, stmt);
+    return make_node<BoundBranch>(branch->location(), cond, stmt);
 }
 
 ErrorOr<BoundBranches, SyntaxError> new_branches(BoundBranches current_branches, FoldContext& ctx, ProcessResult &result)
@@ -200,7 +200,7 @@ ErrorOr<BoundBranches, SyntaxError> new_branches(BoundBranches current_branches,
             // This is a constant-true branch. If we're not building a new
             // statement, return this statement. Else add this if it's the
             // first constant true branch:
-            auto else_branch = std::make_shared<BoundBranch>(branch->location(), nullptr, branch);
+            auto else_branch = make_node<BoundBranch>(branch->location(), nullptr, branch);
             if (new_branches.empty())
                 return BoundBranches { else_branch };
             new_branches.push_back(else_branch);
@@ -223,13 +223,13 @@ NODE_PROCESSOR(BoundIfStatement)
 
     if (branches.empty())
         // Nothing left. Everything was false and there was no 'else' branch:
-        return std::make_shared<Pass>(stmt->location());
+        return make_node<Pass>(stmt->location());
 
     if ((branches.size() == 1) && (branches[0]->condition() == nullptr))
         // First branch is always true, or only 'else' branch left:
         return branches[0]->statement();
 
-    return std::make_shared<BoundIfStatement>(stmt->location(), branches);
+    return make_node<BoundIfStatement>(stmt->location(), branches);
 }
 
 NODE_PROCESSOR(BoundSwitchStatement)
@@ -246,14 +246,14 @@ NODE_PROCESSOR(BoundSwitchStatement)
         if (default_branch != nullptr) {
             return default_branch->statement();
         }
-        return std::make_shared<Pass>(stmt->location());
+        return make_node<Pass>(stmt->location());
     }
 
     if ((branches.size() == 1) && (branches[0]->condition() == nullptr))
         return branches[0]->statement();
     if (branches[branches.size()-1]->condition() == nullptr)
         default_branch = nullptr;
-    return std::make_shared<BoundSwitchStatement>(stmt->location(), expr, branches, default_branch);
+    return make_node<BoundSwitchStatement>(stmt->location(), expr, branches, default_branch);
 }
 
 ProcessResult& fold_constants(ProcessResult& result)
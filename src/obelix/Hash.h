@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace Obelix {
+
+// 64-bit FNV-1a. Used for on-disk cache keys, so unlike std::hash the result
+// is stable across runs and builds of the compiler.
+class ContentHash {
+public:
+    ContentHash() = default;
+
+    ContentHash& add(std::string_view const& data)
+    {
+        update(data);
+        // Separator, so that add("ab").add("c") differs from add("a").add("bc"):
+        m_hash ^= 0xffu;
+        m_hash *= Prime;
+        return *this;
+    }
+
+    // Hashes data without a separator, so that data fed in pieces hashes the
+    // same as when it is fed in one go.
+    ContentHash& update(std::string_view const& data)
+    {
+        for (auto ch : data) {
+            m_hash ^= static_cast<uint8_t>(ch);
+            m_hash *= Prime;
+        }
+        return *this;
+    }
+
+    [[nodiscard]] uint64_t value() const { return m_hash; }
+
+    [[nodiscard]] std::string to_string() const
+    {
+        char buf[17];
+        snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(m_hash));
+        return buf;
+    }
+
+private:
+    constexpr static uint64_t Prime = 0x100000001b3ull;
+    uint64_t m_hash { 0xcbf29ce484222325ull };
+};
+
+}
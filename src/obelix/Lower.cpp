@@ -4,6 +4,10 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+#include <atomic>
+#include <unordered_set>
+
 #include <obelix/Syntax.h>
 #include <obelix/BoundSyntaxNode.h>
 #include <obelix/Processor.h>
@@ -13,28 +17,185 @@ namespace Obelix {
 extern_logging_category(parser);
 
 class LowerContextPayload {
+public:
+    // Statements evaluating the logical and/or values of the statement being
+    // lowered, to be placed in front of it. Null where there is nowhere to put
+    // them, for example while lowering the condition of a loop.
+    Statements* preamble { nullptr };
+
+    // The logical and/or values that can be moved into the preamble without
+    // changing the order in which the statement evaluates things.
+    std::unordered_set<SyntaxNode const*> hoistable {};
 };
 
 using LowerContext = Context<bool, LowerContextPayload>;
 
 INIT_NODE_PROCESSOR(LowerContext)
 
+static bool is_logical_condition(pBoundExpression const& condition)
+{
+    if (auto unary = std::dynamic_pointer_cast<BoundUnaryExpression>(condition); unary != nullptr && unary->op() == UnaryOperator::LogicalInvert)
+        return is_logical_condition(unary->operand());
+    auto binary = std::dynamic_pointer_cast<BoundBinaryExpression>(condition);
+    return binary != nullptr && (binary->op() == BinaryOperator::LogicalAnd || binary->op() == BinaryOperator::LogicalOr);
+}
+
+static bool is_logical_value(pSyntaxNode const& node)
+{
+    auto binary = std::dynamic_pointer_cast<BoundBinaryExpression>(node);
+    return binary != nullptr && (binary->op() == BinaryOperator::LogicalAnd || binary->op() == BinaryOperator::LogicalOr);
+}
+
+static bool contains_logical_value(pSyntaxNode const& node)
+{
+    if (is_logical_value(node))
+        return true;
+    for (auto const& child : node->children()) {
+        if (child != nullptr && contains_logical_value(child))
+            return true;
+    }
+    return false;
+}
+
+static bool has_side_effects(pSyntaxNode const& node)
+{
+    if (node == nullptr)
+        return false;
+    if (std::dynamic_pointer_cast<BoundFunctionCall>(node) != nullptr || std::dynamic_pointer_cast<BoundAssignment>(node) != nullptr)
+        return true;
+    if (auto unary = std::dynamic_pointer_cast<BoundUnaryExpression>(node); unary != nullptr && (unary->op() == UnaryOperator::UnaryIncrement || unary->op() == UnaryOperator::UnaryDecrement))
+        return true;
+    auto children = node->children();
+    return std::any_of(children.begin(), children.end(), [](auto const& child) { return has_side_effects(child); });
+}
+
+// What the part of a statement evaluated so far does.
+struct EvaluatedBefore {
+    bool reads_variables { false };
+    bool has_side_effects { false };
+};
+
+//
+// Marks the logical values in an expression that can be computed in front
+// of the statement it belongs to. Moving a logical value there means that
+// it is evaluated before everything to its left, so that is only allowed if
+// the things to its left have no side effects, and, if the logical value
+// has side effects itself, don't read any variables:
+//
+// var r = f(g(), a && b);   g() must run before a && b, nothing is moved
+// var r = f(x, a && b);     a && b is moved
+// var r = f(x, a && h());   h() could change x, nothing is moved
+//
+// Logical values that stay put are evaluated like any other operator.
+//
+static void mark_hoistable(pSyntaxNode const& node, LowerContext& ctx, EvaluatedBefore& before)
+{
+    if (node == nullptr)
+        return;
+    if (is_logical_value(node)) {
+        auto side_effects = has_side_effects(node);
+        if (!before.has_side_effects && (!side_effects || !before.reads_variables))
+            ctx().hoistable.insert(node.get());
+        before.reads_variables = true;
+        before.has_side_effects |= side_effects;
+        return;
+    }
+    if (auto assignment = std::dynamic_pointer_cast<BoundAssignment>(node); assignment != nullptr && std::dynamic_pointer_cast<BoundIdentifier>(assignment->assignee()) != nullptr) {
+        // A variable is only written once the value is known:
+        mark_hoistable(assignment->expression(), ctx, before);
+        before.has_side_effects = true;
+        return;
+    }
+    for (auto const& child : node->children())
+        mark_hoistable(child, ctx, before);
+    if (std::dynamic_pointer_cast<BoundVariableAccess>(node) != nullptr)
+        before.reads_variables = true;
+    if (has_side_effects(node))
+        before.has_side_effects = true;
+}
+
+static void mark_hoistable(pSyntaxNode const& node, LowerContext& ctx)
+{
+    EvaluatedBefore before;
+    mark_hoistable(node, ctx, before);
+}
+
+//
+// Lowers a statement that isn't directly part of a block, like the body of
+// a loop. A declaration that needed a preamble comes back as a list of
+// statements, to be spliced into the enclosing block. Here there is no such
+// block, so the statements get one of their own.
+//
+static ErrorOr<std::shared_ptr<Statement>, SyntaxError> lower_body(std::shared_ptr<Statement> const& statement, LowerContext& ctx, ProcessResult& result)
+{
+    auto processed = TRY(process(statement, ctx, result));
+    if (auto statements = std::dynamic_pointer_cast<NodeList<Statement>>(processed); statements != nullptr)
+        return make_node<Block>(statement->location(), Statements { statements->begin(), statements->end() });
+    return std::dynamic_pointer_cast<Statement>(processed);
+}
+
+//
+// Appends statements jumping to target if condition evaluates to value.
+// The operands of logical and and or are tested one after the other, so
+// that the right hand side is only evaluated if the left hand side doesn't
+// decide the outcome:
+//
+// if (!(a && b)) goto label_0;
+// ==>
+//   if (!a) goto label_0;
+//   if (!b) goto label_0;
+//
+// if (a && b) goto label_0;
+// ==>
+//   if (!a) goto label_1;
+//   if (b) goto label_0;
+// label_1:
+//
+static void conditional_jump(Statements& statements, pBoundExpression const& condition, bool value, std::shared_ptr<Label> const& target)
+{
+    auto location = condition->location();
+    if (auto unary = std::dynamic_pointer_cast<BoundUnaryExpression>(condition); unary != nullptr && unary->op() == UnaryOperator::LogicalInvert) {
+        conditional_jump(statements, unary->operand(), !value, target);
+        return;
+    }
+    if (is_logical_condition(condition)) {
+        auto binary = std::dynamic_pointer_cast<BoundBinaryExpression>(condition);
+        if ((binary->op() == BinaryOperator::LogicalAnd) != value) {
+            conditional_jump(statements, binary->lhs(), value, target);
+            conditional_jump(statements, binary->rhs(), value, target);
+        } else {
+            auto skip = make_node<Label>(location);
+            conditional_jump(statements, binary->lhs(), !value, skip);
+            conditional_jump(statements, binary->rhs(), value, target);
+            statements.push_back(skip);
+        }
+        return;
+    }
+    auto test = condition;
+    if (!value)
+        test = make_node<BoundUnaryExpression>(location, condition, UnaryOperator::LogicalInvert, ObjectType::get(PrimitiveType::Boolean));
+    statements.push_back(make_node<BoundIfStatement>(location,
+        BoundBranches {
+            make_node<BoundBranch>(location, test, make_node<Goto>(location, target)),
+        }));
+}
+
 NODE_PROCESSOR(BoundFunctionDef)
 {
     auto func_def = std::dynamic_pointer_cast<BoundFunctionDef>(tree);
     if (func_def->statement()) {
-        auto statement = TRY_AND_CAST(Statement, func_def->statement(), ctx);
+        auto statement = TRY(lower_body(func_def->statement(), ctx, result));
         switch (statement->node_type()) {
         case SyntaxNodeType::Block: {
             auto block = std::dynamic_pointer_cast<Block>(statement);
-            return std::make_shared<BoundFunctionDef>(func_def, std::make_shared<FunctionBlock>(block->location(), block->statements(), func_def->declaration()));
+            return make_node<BoundFunctionDef>(func_def, make_node<FunctionBlock>(block->location(), block->statements(), func_def->declaration()));
         }
         case SyntaxNodeType::FunctionBlock: {
             auto block = std::dynamic_pointer_cast<FunctionBlock>(statement);
-            return std::make_shared<BoundFunctionDef>(func_def, block);
+            return make_node<BoundFunctionDef>(func_def, block);
         }
         default:
-            return std::make_shared<BoundFunctionDef>(func_def, std::make_shared<FunctionBlock>(statement->location(), statement, func_def->declaration()));
+            return make_node<BoundFunctionDef>(func_def, make_node<FunctionBlock>(statement->location(), statement, func_def->declaration()));
         }
     }
     return tree;
@@ -66,25 +227,115 @@ NODE_PROCESSOR(BoundSwitchStatement)
 
     BoundBranches branches;
     for (auto& c : cases) {
-        branches.push_back(std::make_shared<BoundBranch>(c->location(),
-            std::make_shared<BoundBinaryExpression>(switch_expr->location(), switch_expr, BinaryOperator::Equals, c->condition(), ObjectType::get(PrimitiveType::Boolean)),
+        branches.push_back(make_node<BoundBranch>(c->location(),
+            make_node<BoundBinaryExpression>(switch_expr->location(), switch_expr, BinaryOperator::Equals, c->condition(), ObjectType::get(PrimitiveType::Boolean)),
             c->statement()));
     }
     if (default_case) {
-        auto default_stmt = TRY_AND_CAST(Statement, default_case->statement(), ctx);
-        branches.push_back(std::make_shared<BoundBranch>(default_case->location(), nullptr, default_stmt));
+        auto default_stmt = TRY(lower_body(default_case->statement(), ctx, result));
+        branches.push_back(make_node<BoundBranch>(default_case->location(), nullptr, default_stmt));
+    }
+    return TRY(process(make_node<BoundIfStatement>(switch_stmt->location(), branches), ctx, result));
+}
+
+NODE_PROCESSOR(BoundIfStatement)
+{
+    auto if_stmt = std::dynamic_pointer_cast<BoundIfStatement>(tree);
+    if (ctx.config().target == Architecture::C_TRANSPILER) {
+        BoundBranches branches;
+        for (auto& branch : if_stmt->branches()) {
+            branches.push_back(TRY_AND_CAST(BoundBranch, branch, ctx));
+        }
+        return make_node<BoundIfStatement>(if_stmt->location(), branches);
     }
-    return TRY(process(std::make_shared<BoundIfStatement>(switch_stmt->location(), branches), ctx, result));
+
+    // Only the condition of the first branch is evaluated every time the if
+    // statement is, so only that one can have its logical values computed in
+    // front of the statement. Logical conditions are lowered to jumps below.
+    Statements preamble;
+    BoundBranches branches;
+    auto logical_conditions { false };
+    for (auto& branch : if_stmt->branches()) {
+        pBoundExpression condition { nullptr };
+        if (branch->condition() != nullptr) {
+            auto outer_preamble = ctx().preamble;
+            auto outer_hoistable = std::move(ctx().hoistable);
+            ctx().hoistable.clear();
+            ctx().preamble = nullptr;
+            if (branches.empty() && !is_logical_condition(branch->condition())) {
+                ctx().preamble = &preamble;
+                mark_hoistable(branch->condition(), ctx);
+            }
+            auto condition_or_error = try_and_cast<BoundExpression>(branch->condition(), ctx, result);
+            ctx().preamble = outer_preamble;
+            ctx().hoistable = std::move(outer_hoistable);
+            if (condition_or_error.is_error())
+                return condition_or_error.error();
+            condition = condition_or_error.value();
+            if (is_logical_condition(condition) || (!branches.empty() && contains_logical_value(condition)))
+                logical_conditions = true;
+        }
+        auto statement = TRY(lower_body(branch->statement(), ctx, result));
+        branches.push_back(make_node<BoundBranch>(branch, condition, statement));
+    }
+
+    if (!logical_conditions) {
+        if (preamble.empty())
+            return make_node<BoundIfStatement>(if_stmt->location(), branches);
+        preamble.push_back(make_node<BoundIfStatement>(if_stmt->location(), branches));
+        return make_node<Block>(if_stmt->location(), preamble);
+    }
+
+    //
+    // if (x > 0 && y > 0) {
+    //   foo();
+    // } else {
+    //   bar();
+    // }
+    // ==>
+    // {
+    //   if (!(x>0)) goto label_0;
+    //   if (!(y>0)) goto label_0;
+    //   foo();
+    //   goto label_1;
+    // label_0:
+    //   bar();
+    // label_1:
+    // }
+    //
+    // The jumps are lowered once more, to deal with logical values nested
+    // in the conditions they test.
+    //
+
+    Statements if_block = preamble;
+    auto end_of_if = make_node<Label>(if_stmt->location());
+    for (auto const& branch : branches) {
+        if (branch->condition() == nullptr) {
+            if_block.push_back(branch->statement());
+            break;
+        }
+        auto next_branch = make_node<Label>(branch->location());
+        Statements jumps;
+        conditional_jump(jumps, branch->condition(), false, next_branch);
+        for (auto const& jump : jumps) {
+            if_block.push_back(TRY_AND_CAST(Statement, jump, ctx));
+        }
+        if_block.push_back(branch->statement());
+        if_block.push_back(make_node<Goto>(branch->location(), end_of_if));
+        if_block.push_back(next_branch);
+    }
+    if_block.push_back(end_of_if);
+    return make_node<Block>(if_stmt->location(), if_block);
 }
 
 NODE_PROCESSOR(BoundWhileStatement)
 {
     auto while_stmt = std::dynamic_pointer_cast<BoundWhileStatement>(tree);
     auto condition = TRY_AND_CAST(BoundExpression, while_stmt->condition(), ctx);
-    auto stmt = TRY_AND_CAST(Statement, while_stmt->statement(), ctx);
+    auto stmt = TRY(lower_body(while_stmt->statement(), ctx, result));
 
     if (ctx.config().target == Architecture::C_TRANSPILER) {
-        return std::make_shared<BoundWhileStatement>(while_stmt, condition, stmt);
+        return make_node<BoundWhileStatement>(while_stmt, condition, stmt);
     }
 
     //
@@ -104,21 +355,14 @@ NODE_PROCESSOR(BoundWhileStatement)
     //
 
     Statements while_block;
-    auto start_of_loop = std::make_shared<Label>(while_stmt->location());
-    auto jump_out_of_loop = std::make_shared<Goto>(while_stmt->location());
+    auto start_of_loop = make_node<Label>(while_stmt->location());
+    auto end_of_loop = make_node<Label>(while_stmt->location());
     while_block.push_back(start_of_loop);
-
-    BoundBranches branches {
-        std::make_shared<BoundBranch>(while_stmt->location(),
-            std::make_shared<BoundUnaryExpression>(condition->location(),
-                condition, UnaryOperator::LogicalInvert, ObjectType::get(PrimitiveType::Boolean)),
-            jump_out_of_loop),
-    };
-    while_block.push_back(std::make_shared<BoundIfStatement>(condition->location(), branches));
+    conditional_jump(while_block, condition, false, end_of_loop);
     while_block.push_back(stmt);
-    while_block.push_back(std::make_shared<Goto>(while_stmt->location(), start_of_loop));
-    while_block.push_back(std::make_shared<Label>(jump_out_of_loop));
-    return TRY(process(std::make_shared<Block>(while_stmt->location(), while_block), ctx, result));
+    while_block.push_back(make_node<Goto>(while_stmt->location(), start_of_loop));
+    while_block.push_back(end_of_loop);
+    return TRY(process(make_node<Block>(while_stmt->location(), while_block), ctx, result));
 }
 
 NODE_PROCESSOR(BoundForStatement)
@@ -129,9 +373,9 @@ NODE_PROCESSOR(BoundForStatement)
         auto range = std::dynamic_pointer_cast<BoundBinaryExpression>(for_stmt->range());
         auto range_low = TRY_AND_CAST(BoundExpression, range->lhs(), ctx);
         auto range_high = TRY_AND_CAST(BoundExpression, range->rhs(), ctx);
-        range = std::make_shared<BoundBinaryExpression>(range->location(), range_low, BinaryOperator::Range, range_high, range->type());
-        auto stmt = TRY_AND_CAST(Statement, for_stmt->statement(), ctx);
-        return std::make_shared<BoundForStatement>(for_stmt, variable, range, stmt);
+        range = make_node<BoundBinaryExpression>(range->location(), range_low, BinaryOperator::Range, range_high, range->type());
+        auto stmt = TRY(lower_body(for_stmt->statement(), ctx, result));
+        return make_node<BoundForStatement>(for_stmt, variable, range, stmt);
     }
 
     //
@@ -151,7 +395,7 @@ NODE_PROCESSOR(BoundForStatement)
     //
     auto for_stmt = std::dynamic_pointer_cast<BoundForStatement>(tree);
     auto range_expr = TRY_AND_CAST(BoundExpression, for_stmt->range(), ctx);
-    auto stmt = TRY_AND_CAST(Statement, for_stmt->statement(), ctx);
+    auto stmt = TRY(lower_body(for_stmt->statement(), ctx, result));
 
     if (range_expr->node_type() != SyntaxNodeType::BoundBinaryExpression)
         return SyntaxError { for_stmt->location(), "Invalid for-loop range" };
@@ -164,16 +408,16 @@ NODE_PROCESSOR(BoundForStatement)
 
     if (for_stmt->must_declare_variable()) {
         for_block.push_back(
-            std::make_shared<BoundVariableDeclaration>(for_stmt->location(), for_stmt->variable(), false, range_binary_expr->lhs()));
+            make_node<BoundVariableDeclaration>(for_stmt->location(), for_stmt->variable(), false, range_binary_expr->lhs()));
     } else {
         for_block.push_back(
-            std::make_shared<BoundExpressionStatement>(for_stmt->location(),
-                std::make_shared<BoundAssignment>(for_stmt->location(),
+            make_node<BoundExpressionStatement>(for_stmt->location(),
+                make_node<BoundAssignment>(for_stmt->location(),
                     for_stmt->variable(),
                     range_binary_expr->lhs())));
     }
-    auto jump_past_loop = std::make_shared<Goto>();
-    auto jump_back_label = std::make_shared<Label>();
+    auto jump_past_loop = make_node<Goto>();
+    auto jump_back_label = make_node<Label>();
 
     for_block.push_back(jump_back_label);
 
@@ -183,28 +427,125 @@ NODE_PROCESSOR(BoundForStatement)
         rhs = TRY(rhs_int->cast(variable_type));
     }
 
-    for_block.push_back(std::make_shared<BoundIfStatement>(for_stmt->location(),
+    for_block.push_back(make_node<BoundIfStatement>(for_stmt->location(),
         BoundBranches {
-            std::make_shared<BoundBranch>(for_stmt->location(),
-                std::make_shared<BoundBinaryExpression>(for_stmt->location(),
+            make_node<BoundBranch>(for_stmt->location(),
+                make_node<BoundBinaryExpression>(for_stmt->location(),
                     for_stmt->variable(), BinaryOperator::GreaterEquals, rhs, ObjectType::get(PrimitiveType::Boolean)),
                 jump_past_loop),
         }));
     for_block.push_back(stmt);
     for_block.push_back(
-        std::make_shared<BoundExpressionStatement>(range_binary_expr->location(),
-            std::make_shared<BoundUnaryExpression>(range_binary_expr->location(),
+        make_node<BoundExpressionStatement>(range_binary_expr->location(),
+            make_node<BoundUnaryExpression>(range_binary_expr->location(),
                 for_stmt->variable(),
                 UnaryOperator::UnaryIncrement,
                 variable_type)));
-    for_block.push_back(std::make_shared<Goto>(for_stmt->location(), jump_back_label));
-    for_block.push_back(std::make_shared<Label>(jump_past_loop));
-    return TRY(process(std::make_shared<Block>(stmt->location(), for_block), ctx, result));
+    for_block.push_back(make_node<Goto>(for_stmt->location(), jump_back_label));
+    for_block.push_back(make_node<Label>(jump_past_loop));
+    return TRY(process(make_node<Block>(stmt->location(), for_block), ctx, result));
+}
+
+//
+// Lowers a statement computing the given value, which can have logical
+// and/or values. The statements computing those values are placed in front
+// of it.
+//
+static ErrorOrNode lower_statement(std::shared_ptr<SyntaxNode> const& tree, pBoundExpression const& value, LowerContext& ctx, ProcessResult& result)
+{
+    if (ctx.config().target == Architecture::C_TRANSPILER)
+        return process_tree(tree, ctx, result, LowerContext_processor);
+
+    Statements preamble;
+    auto outer_preamble = ctx().preamble;
+    auto outer_hoistable = std::move(ctx().hoistable);
+    ctx().preamble = &preamble;
+    ctx().hoistable.clear();
+    mark_hoistable(value, ctx);
+    auto processed = process_tree(tree, ctx, result, LowerContext_processor);
+    ctx().preamble = outer_preamble;
+    ctx().hoistable = std::move(outer_hoistable);
+    if (processed.is_error() || preamble.empty())
+        return processed;
+    preamble.push_back(std::dynamic_pointer_cast<Statement>(processed.value()));
+
+    // A declared variable must remain visible to the statements following
+    // it, so declarations are spliced into the enclosing block. See
+    // lower_body for statements that aren't part of a block.
+    if (tree->node_type() == SyntaxNodeType::BoundVariableDeclaration)
+        return make_node<NodeList<Statement>>("statements", preamble);
+    return make_node<Block>(tree->location(), preamble);
+}
+
+NODE_PROCESSOR(BoundVariableDeclaration)
+{
+    auto decl = std::dynamic_pointer_cast<BoundVariableDeclaration>(tree);
+    return lower_statement(tree, decl->expression(), ctx, result);
+}
+
+NODE_PROCESSOR(BoundExpressionStatement)
+{
+    auto stmt = std::dynamic_pointer_cast<BoundExpressionStatement>(tree);
+    return lower_statement(tree, stmt->expression(), ctx, result);
+}
+
+NODE_PROCESSOR(BoundReturn)
+{
+    auto ret = std::dynamic_pointer_cast<BoundReturn>(tree);
+    return lower_statement(tree, ret->expression(), ctx, result);
+}
+
+// Switch cases and the branches of if statements lowered for the C
+// transpiler.
+NODE_PROCESSOR(BoundBranch)
+{
+    auto branch = std::dynamic_pointer_cast<BoundBranch>(tree);
+    pBoundExpression condition { nullptr };
+    if (branch->condition() != nullptr)
+        condition = TRY_AND_CAST(BoundExpression, branch->condition(), ctx);
+    auto statement = TRY(lower_body(branch->statement(), ctx, result));
+    if (condition == branch->condition() && statement == branch->statement())
+        return tree;
+    return make_node<BoundBranch>(branch, condition, statement);
 }
 
 NODE_PROCESSOR(BoundBinaryExpression)
 {
     auto expr = std::dynamic_pointer_cast<BoundBinaryExpression>(tree);
+
+    if (ctx().preamble != nullptr && ctx().hoistable.contains(tree.get())) {
+        //
+        // var ok = x > 0 && y > 0;
+        // ==>
+        //   var $logical_0: bool = x > 0;
+        //   if (!$logical_0) goto label_0;
+        //   $logical_0 = y > 0;
+        // label_0:
+        //   var ok = $logical_0;
+        //
+        // The right hand side is lowered after the jump, so that the values
+        // it computes itself are only computed if it is evaluated. Both
+        // sides are the whole value of a statement in the preamble, so the
+        // logical values they contain can be moved in front of that.
+        //
+        static std::atomic<int> logical_count { 0 };
+        auto location = expr->location();
+        auto name = format("$logical_{}", logical_count++);
+        auto boolean = ObjectType::get(PrimitiveType::Boolean);
+        auto& preamble = *ctx().preamble;
+        mark_hoistable(expr->lhs(), ctx);
+        auto lhs = TRY_AND_CAST(BoundExpression, expr->lhs(), ctx);
+        preamble.push_back(make_node<BoundVariableDeclaration>(location, make_node<BoundIdentifier>(location, name, boolean), false, lhs));
+        auto done = make_node<Label>(location);
+        conditional_jump(preamble, make_node<BoundVariable>(location, name, boolean), expr->op() == BinaryOperator::LogicalOr, done);
+        mark_hoistable(expr->rhs(), ctx);
+        auto rhs = TRY_AND_CAST(BoundExpression, expr->rhs(), ctx);
+        preamble.push_back(make_node<BoundExpressionStatement>(location,
+            make_node<BoundAssignment>(location, make_node<BoundVariable>(location, name, boolean), rhs)));
+        preamble.push_back(done);
+        return make_node<BoundVariable>(location, name, boolean);
+    }
+
     auto lhs = TRY_AND_CAST(BoundExpression, expr->lhs(), ctx);
     auto rhs = TRY_AND_CAST(BoundExpression, expr->rhs(), ctx);
 
@@ -213,33 +554,35 @@ NODE_PROCESSOR(BoundBinaryExpression)
     }
 
     if (expr->op() == BinaryOperator::GreaterEquals) {
-        return std::make_shared<BoundBinaryExpression>(expr->location(),
-            std::make_shared<BoundBinaryExpression>(expr->location(),
+        return make_node<BoundBinaryExpression>(expr->location(),
+            make_node<BoundBinaryExpression>(expr->location(),
                 lhs, BinaryOperator::Equals, rhs, ObjectType::get(PrimitiveType::Boolean)),
             BinaryOperator::LogicalOr,
-            std::make_shared<BoundBinaryExpression>(expr->location(),
+            make_node<BoundBinaryExpression>(expr->location(),
                 lhs, BinaryOperator::Greater, rhs, ObjectType::get(PrimitiveType::Boolean)),
             ObjectType::get(PrimitiveType::Boolean));
     }
 
     if (expr->op() == BinaryOperator::LessEquals) {
-        return std::make_shared<BoundBinaryExpression>(expr->location(),
-            std::make_shared<BoundBinaryExpression>(expr->location(),
+        return make_node<BoundBinaryExpression>(expr->location(),
+            make_node<BoundBinaryExpression>(expr->location(),
                 lhs, BinaryOperator::Equals, rhs, ObjectType::get(PrimitiveType::Boolean)),
             BinaryOperator::LogicalOr,
-            std::make_shared<BoundBinaryExpression>(expr->location(),
+            make_node<BoundBinaryExpression>(expr->location(),
                 lhs, BinaryOperator::Less, rhs, ObjectType::get(PrimitiveType::Boolean)),
             ObjectType::get(PrimitiveType::Boolean));
     }
 
     if (expr->op() == BinaryOperator::NotEquals) {
-        return std::make_shared<BoundUnaryExpression>(expr->location(),
-            std::make_shared<BoundBinaryExpression>(expr->location(),
+        return make_node<BoundUnaryExpression>(expr->location(),
+            make_node<BoundBinaryExpression>(expr->location(),
                 lhs, BinaryOperator::Equals, rhs, ObjectType::get(PrimitiveType::Boolean)),
             UnaryOperator::LogicalInvert,
             ObjectType::get(PrimitiveType::Boolean));
     }
 
+    if (lhs != expr->lhs() || rhs != expr->rhs())
+        return make_node<BoundBinaryExpression>(expr->location(), lhs, expr->op(), rhs, expr->type());
     return expr;
 }
 
@@ -249,13 +592,15 @@ NODE_PROCESSOR(BoundUnaryExpression)
     auto operand = TRY_AND_CAST(BoundExpression, expr->operand(), ctx);
     if (expr->op() == UnaryOperator::UnaryIncrement || expr->op() == UnaryOperator::UnaryDecrement) {
         auto identifier = std::dynamic_pointer_cast<BoundIdentifier>(operand);
-        auto new_rhs = std::make_shared<BoundBinaryExpression>(expr->location(),
+        auto new_rhs = make_node<BoundBinaryExpression>(expr->location(),
             identifier,
             (expr->op() == UnaryOperator::UnaryIncrement) ? BinaryOperator::Add : BinaryOperator::Subtract,
-            std::make_shared<BoundIntLiteral>(expr->location(), 1l, identifier->type()),
+            make_node<BoundIntLiteral>(expr->location(), 1l, identifier->type()),
             identifier->type());
-        return std::make_shared<BoundAssignment>(expr->location(), identifier, new_rhs);
+        return make_node<BoundAssignment>(expr->location(), identifier, new_rhs);
     }
+    if (operand != expr->operand())
+        return make_node<BoundUnaryExpression>(expr->location(), operand, expr->op(), expr->type());
     return tree;
 }
 
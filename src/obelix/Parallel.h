@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Obelix {
+
+// Calls job(ix) for every ix in [0, count), using at most max_jobs threads
+// including the calling one. Jobs are handed out in index order, but can
+// complete in any order; jobs should store their results by index.
+template<typename Job>
+void parallel_for(size_t count, unsigned int max_jobs, Job const& job)
+{
+    std::atomic<size_t> next { 0 };
+    auto worker = [count, &next, &job]() {
+        for (auto ix = next++; ix < count; ix = next++)
+            job(ix);
+    };
+
+    std::vector<std::thread> workers;
+    auto num_workers = std::min(static_cast<size_t>(std::max(max_jobs, 1u)), count);
+    for (auto ix = 1u; ix < num_workers; ++ix)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& w : workers)
+        w.join();
+}
+
+}
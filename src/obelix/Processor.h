@@ -10,6 +10,7 @@
 #include <memory>
 #include <unordered_map>
 
+#include <config.h>
 #include <core/Error.h>
 #include <obelix/BoundSyntaxNode.h>
 #include <obelix/Config.h>
@@ -21,6 +22,19 @@ namespace Obelix {
 
 extern_logging_category(processor);
 
+// Tracing every node visit means formatting every input and output node,
+// which costs more than most processors themselves. So it is only done if
+// the processor category is enabled, and is compiled out entirely when
+// configured with -DOBELIX_TRACE=OFF.
+inline bool processor_trace_enabled()
+{
+#if OBELIX_TRACE
+    return processor_logger.enabled();
+#else
+    return false;
+#endif
+}
+
 using ErrorOrNode = ErrorOr<std::shared_ptr<SyntaxNode>, SyntaxError>;
 
 template<class NodeClass>
@@ -153,7 +167,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         for (auto& type : compilation->custom_types()) {
             types.push_back(TRY_AND_CAST(BoundType, type, ctx));
         }
-        ret = std::make_shared<BoundCompilation>(modules, types, compilation->main_module());
+        ret = make_node<BoundCompilation>(modules, types, compilation->main_module());
         break;
     }
 
@@ -180,7 +194,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto processed_arg = TRY_AND_CAST(ExpressionType, arg, ctx);
             arguments.push_back(arg);
         }
-        return std::make_shared<ExpressionType>(expr_type->location(), expr_type->type_name(), arguments);
+        return make_node<ExpressionType>(expr_type->location(), expr_type->type_name(), arguments);
     }
 
     case SyntaxNodeType::StructDefinition: {
@@ -190,7 +204,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto processed_field = TRY_AND_CAST(Identifier, field, ctx);
             fields.push_back(processed_field);
         }
-        return std::make_shared<StructDefinition>(struct_def->location(), struct_def->name(), fields);
+        return make_node<StructDefinition>(struct_def->location(), struct_def->name(), fields);
     }
 
     case SyntaxNodeType::BoundStructDefinition: {
@@ -205,7 +219,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto processed_method = TRY_AND_CAST(Statement, method, ctx);
             methods.push_back(processed_method);
         }
-        return std::make_shared<BoundStructDefinition>(struct_def->location(), struct_def->type(), fields, methods);
+        return make_node<BoundStructDefinition>(struct_def->location(), struct_def->type(), fields, methods);
     }
 
     case SyntaxNodeType::EnumDef: {
@@ -215,7 +229,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto processed_value = TRY_AND_CAST(EnumValue, value, ctx);
             values.push_back(processed_value);
         }
-        return std::make_shared<EnumDef>(enum_def->location(), enum_def->name(), values, enum_def->extend());
+        return make_node<EnumDef>(enum_def->location(), enum_def->name(), values, enum_def->extend());
     }
 
     case SyntaxNodeType::BoundEnumDef: {
@@ -225,19 +239,19 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto processed_value = TRY_AND_CAST(BoundEnumValueDef, value, ctx);
             values.push_back(processed_value);
         }
-        return std::make_shared<BoundEnumDef>(enum_def->location(), enum_def->name(), enum_def->type(), values, enum_def->extend());
+        return make_node<BoundEnumDef>(enum_def->location(), enum_def->name(), enum_def->type(), values, enum_def->extend());
     }
 
     case SyntaxNodeType::TypeDef: {
         auto type_def = std::dynamic_pointer_cast<TypeDef>(tree);
         auto type = TRY_AND_CAST(ExpressionType, type_def, ctx);
-        return std::make_shared<TypeDef>(type_def->location(), type_def->name(), type);
+        return make_node<TypeDef>(type_def->location(), type_def->name(), type);
     }
 
     case SyntaxNodeType::BoundTypeDef: {
         auto type_def = std::dynamic_pointer_cast<BoundTypeDef>(tree);
         auto type = TRY_AND_CAST(BoundType, type_def->type(), ctx);
-        return std::make_shared<BoundTypeDef>(type_def->location(), type_def->name(), type);
+        return make_node<BoundTypeDef>(type_def->location(), type_def->name(), type);
     }
 
     case SyntaxNodeType::FunctionDef: {
@@ -246,7 +260,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto statement = func_def->statement();
         if (statement)
             statement = TRY_AND_CAST(Statement, statement, ctx);
-        ret = std::make_shared<FunctionDef>(func_def->location(), func_decl, statement);
+        ret = make_node<FunctionDef>(func_def->location(), func_decl, statement);
         break;
     }
 
@@ -256,7 +270,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto statement = func_def->statement();
         if (statement)
             statement = TRY_AND_CAST(Statement, statement, ctx);
-        ret = std::make_shared<BoundFunctionDef>(func_def->location(), func_decl, statement);
+        ret = make_node<BoundFunctionDef>(func_def->location(), func_decl, statement);
         break;
     }
 
@@ -272,14 +286,14 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         }
         switch (func_decl->node_type()) {
         case SyntaxNodeType::FunctionDecl:
-            ret = std::make_shared<FunctionDecl>(func_decl->location(), func_decl->module(), identifier, parameters);
+            ret = make_node<FunctionDecl>(func_decl->location(), func_decl->module(), identifier, parameters);
             break;
         case SyntaxNodeType::NativeFunctionDecl:
-            ret = std::make_shared<NativeFunctionDecl>(func_decl->location(), func_decl->module(), identifier, parameters,
+            ret = make_node<NativeFunctionDecl>(func_decl->location(), func_decl->module(), identifier, parameters,
                 std::dynamic_pointer_cast<NativeFunctionDecl>(func_decl)->native_function_name());
             break;
         case SyntaxNodeType::IntrinsicDecl:
-            ret = std::make_shared<IntrinsicDecl>(func_decl->location(), func_decl->module(), identifier, parameters);
+            ret = make_node<IntrinsicDecl>(func_decl->location(), func_decl->module(), identifier, parameters);
             break;
         default:
             fatal("Unreachable");
@@ -300,16 +314,16 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         }
         switch (func_decl->node_type()) {
         case SyntaxNodeType::BoundFunctionDecl:
-            ret = std::make_shared<BoundFunctionDecl>(func_decl, func_decl->module(), identifier, parameters);
+            ret = make_node<BoundFunctionDecl>(func_decl, func_decl->module(), identifier, parameters);
             break;
         case SyntaxNodeType::BoundNativeFunctionDecl:
-            ret = std::make_shared<BoundNativeFunctionDecl>(std::dynamic_pointer_cast<BoundNativeFunctionDecl>(func_decl), func_decl->module(), identifier, parameters);
+            ret = make_node<BoundNativeFunctionDecl>(std::dynamic_pointer_cast<BoundNativeFunctionDecl>(func_decl), func_decl->module(), identifier, parameters);
             break;
         case SyntaxNodeType::BoundIntrinsicDecl:
-            ret = std::make_shared<BoundIntrinsicDecl>(func_decl, func_decl->module(), identifier, parameters);
+            ret = make_node<BoundIntrinsicDecl>(func_decl, func_decl->module(), identifier, parameters);
             break;
         case SyntaxNodeType::BoundMethodDecl:
-            ret = std::make_shared<BoundMethodDecl>(func_decl, std::dynamic_pointer_cast<BoundMethodDecl>(func_decl)->method());
+            ret = make_node<BoundMethodDecl>(func_decl, std::dynamic_pointer_cast<BoundMethodDecl>(func_decl)->method());
             break;
         default:
             fatal("Unreachable");
@@ -320,7 +334,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
     case SyntaxNodeType::ExpressionStatement: {
         auto stmt = std::dynamic_pointer_cast<ExpressionStatement>(tree);
         auto expr = TRY_AND_CAST(Expression, stmt->expression(), ctx);
-        ret = std::make_shared<ExpressionStatement>(expr);
+        ret = make_node<ExpressionStatement>(expr);
         break;
     }
 
@@ -331,13 +345,13 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto processed = TRY_AND_CAST(Expression, expr, ctx);
             expressions.push_back(processed);
         }
-        return std::make_shared<ExpressionList>(list->location(), expressions);
+        return make_node<ExpressionList>(list->location(), expressions);
     }
 
     case SyntaxNodeType::BoundExpressionStatement: {
         auto stmt = std::dynamic_pointer_cast<BoundExpressionStatement>(tree);
         auto expr = TRY_AND_CAST(BoundExpression, stmt->expression(), ctx);
-        ret = std::make_shared<BoundExpressionStatement>(stmt->location(), expr);
+        ret = make_node<BoundExpressionStatement>(stmt->location(), expr);
         break;
     }
 
@@ -346,7 +360,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
 
         auto lhs = TRY_AND_CAST(Expression, expr->lhs(), ctx);
         auto rhs = TRY_AND_CAST(Expression, expr->rhs(), ctx);
-        ret = std::make_shared<BinaryExpression>(lhs, expr->op(), rhs, expr->type());
+        ret = make_node<BinaryExpression>(lhs, expr->op(), rhs, expr->type());
         break;
     }
 
@@ -355,42 +369,42 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
 
         auto lhs = TRY_AND_CAST(BoundExpression, expr->lhs(), ctx);
         auto rhs = TRY_AND_CAST(BoundExpression, expr->rhs(), ctx);
-        ret = std::make_shared<BoundBinaryExpression>(expr->location(), lhs, expr->op(), rhs, expr->type());
+        ret = make_node<BoundBinaryExpression>(expr->location(), lhs, expr->op(), rhs, expr->type());
         break;
     }
 
     case SyntaxNodeType::UnaryExpression: {
         auto expr = std::dynamic_pointer_cast<UnaryExpression>(tree);
         auto operand = TRY_AND_CAST(Expression, expr->operand(), ctx);
-        ret = std::make_shared<UnaryExpression>(expr->op(), operand, expr->type());
+        ret = make_node<UnaryExpression>(expr->op(), operand, expr->type());
         break;
     }
 
     case SyntaxNodeType::BoundUnaryExpression: {
         auto expr = std::dynamic_pointer_cast<BoundUnaryExpression>(tree);
         auto operand = TRY_AND_CAST(BoundExpression, expr->operand(), ctx);
-        ret = std::make_shared<BoundUnaryExpression>(expr->location(), operand, expr->op(), expr->type());
+        ret = make_node<BoundUnaryExpression>(expr->location(), operand, expr->op(), expr->type());
         break;
     }
 
     case SyntaxNodeType::BoundConditionalValue: {
         auto conditional_value = std::dynamic_pointer_cast<BoundConditionalValue>(tree);
         auto expr = TRY_AND_CAST(BoundExpression, conditional_value->expression(), ctx);
-        ret = std::make_shared<BoundConditionalValue>(conditional_value->location(), expr, conditional_value->success(), conditional_value->type());
+        ret = make_node<BoundConditionalValue>(conditional_value->location(), expr, conditional_value->success(), conditional_value->type());
         break;
     }
 
     case SyntaxNodeType::CastExpression: {
         auto cast_expr = std::dynamic_pointer_cast<CastExpression>(tree);
         auto expr = TRY_AND_CAST(Expression, cast_expr->expression(), ctx);
-        ret = std::make_shared<CastExpression>(cast_expr->location(), expr, cast_expr->type());
+        ret = make_node<CastExpression>(cast_expr->location(), expr, cast_expr->type());
         break;
     }
 
     case SyntaxNodeType::BoundCastExpression: {
         auto cast_expr = std::dynamic_pointer_cast<BoundCastExpression>(tree);
         auto expr = TRY_AND_CAST(BoundExpression, cast_expr->expression(), ctx);
-        ret = std::make_shared<BoundCastExpression>(cast_expr->location(), expr, cast_expr->type());
+        ret = make_node<BoundCastExpression>(cast_expr->location(), expr, cast_expr->type());
         break;
     }
 
@@ -398,63 +412,63 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto assignment = std::dynamic_pointer_cast<BoundAssignment>(tree);
         auto assignee = TRY_AND_CAST(BoundVariableAccess, assignment->assignee(), ctx);
         auto expression = TRY_AND_CAST(BoundExpression, assignment->expression(), ctx);
-        ret = std::make_shared<BoundAssignment>(assignment->location(), assignee, expression);
+        ret = make_node<BoundAssignment>(assignment->location(), assignee, expression);
         break;
     }
 
     case SyntaxNodeType::BoundModule: {
         auto module = std::dynamic_pointer_cast<BoundModule>(tree);
         auto block = TRY_AND_CAST(Block, module->block(), ctx);
-        ret = std::make_shared<BoundModule>(module->location(), module->name(), block, module->exports(), module->imports());
+        ret = make_node<BoundModule>(module->location(), module->name(), block, module->exports(), module->imports());
         break;
     }
 
     case SyntaxNodeType::BoundFunctionCall: {
         auto func_call = std::dynamic_pointer_cast<BoundFunctionCall>(tree);
         auto arguments = TRY(xform_bound_expressions(func_call->arguments(), ctx, result, processor));
-        ret = std::make_shared<BoundFunctionCall>(func_call, arguments);
+        ret = make_node<BoundFunctionCall>(func_call, arguments);
         break;
     }
 
     case SyntaxNodeType::BoundNativeFunctionCall: {
         auto func_call = std::dynamic_pointer_cast<BoundNativeFunctionCall>(tree);
         auto arguments = TRY(xform_bound_expressions(func_call->arguments(), ctx, result, processor));
-        ret = std::make_shared<BoundNativeFunctionCall>(func_call, arguments);
+        ret = make_node<BoundNativeFunctionCall>(func_call, arguments);
         break;
     }
 
     case SyntaxNodeType::BoundIntrinsicCall: {
         auto call = std::dynamic_pointer_cast<BoundIntrinsicCall>(tree);
         auto arguments = TRY(xform_bound_expressions(call->arguments(), ctx, result, processor));
-        ret = std::make_shared<BoundIntrinsicCall>(call, arguments);
+        ret = make_node<BoundIntrinsicCall>(call, arguments);
         break;
     }
 
     case SyntaxNodeType::VariableDeclaration: {
         auto var_decl = std::dynamic_pointer_cast<VariableDeclaration>(tree);
         auto expr = TRY_AND_CAST(Expression, var_decl->expression(), ctx);
-        ret = std::make_shared<VariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
+        ret = make_node<VariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
         break;
     }
 
     case SyntaxNodeType::StaticVariableDeclaration: {
         auto var_decl = std::dynamic_pointer_cast<StaticVariableDeclaration>(tree);
         auto expr = TRY_AND_CAST(Expression, var_decl->expression(), ctx);
-        ret = std::make_shared<StaticVariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
+        ret = make_node<StaticVariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
         break;
     }
 
     case SyntaxNodeType::LocalVariableDeclaration: {
         auto var_decl = std::dynamic_pointer_cast<LocalVariableDeclaration>(tree);
         auto expr = TRY_AND_CAST(Expression, var_decl->expression(), ctx);
-        ret = std::make_shared<LocalVariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
+        ret = make_node<LocalVariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
         break;
     }
 
     case SyntaxNodeType::GlobalVariableDeclaration: {
         auto var_decl = std::dynamic_pointer_cast<GlobalVariableDeclaration>(tree);
         auto expr = TRY_AND_CAST(Expression, var_decl->expression(), ctx);
-        ret = std::make_shared<GlobalVariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
+        ret = make_node<GlobalVariableDeclaration>(var_decl->location(), var_decl->identifier(), expr);
         break;
     }
 
@@ -462,7 +476,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto var_decl = std::dynamic_pointer_cast<BoundVariableDeclaration>(tree);
         auto identifier = TRY_AND_CAST(BoundIdentifier, var_decl->variable(), ctx);
         auto expr = TRY_AND_CAST(BoundExpression, var_decl->expression(), ctx);
-        ret = std::make_shared<BoundVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
+        ret = make_node<BoundVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
         break;
     }
 
@@ -470,7 +484,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto var_decl = std::dynamic_pointer_cast<BoundStaticVariableDeclaration>(tree);
         auto identifier = TRY_AND_CAST(BoundIdentifier, var_decl->variable(), ctx);
         auto expr = TRY_AND_CAST(BoundExpression, var_decl->expression(), ctx);
-        ret = std::make_shared<BoundStaticVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
+        ret = make_node<BoundStaticVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
         break;
     }
 
@@ -478,7 +492,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto var_decl = std::dynamic_pointer_cast<BoundLocalVariableDeclaration>(tree);
         auto identifier = TRY_AND_CAST(BoundIdentifier, var_decl->variable(), ctx);
         auto expr = TRY_AND_CAST(BoundExpression, var_decl->expression(), ctx);
-        ret = std::make_shared<BoundLocalVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
+        ret = make_node<BoundLocalVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
         break;
     }
 
@@ -486,21 +500,21 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto var_decl = std::dynamic_pointer_cast<BoundGlobalVariableDeclaration>(tree);
         auto identifier = TRY_AND_CAST(BoundIdentifier, var_decl->variable(), ctx);
         auto expr = TRY_AND_CAST(BoundExpression, var_decl->expression(), ctx);
-        ret = std::make_shared<BoundGlobalVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
+        ret = make_node<BoundGlobalVariableDeclaration>(var_decl->location(), identifier, var_decl->is_const(), expr);
         break;
     }
 
     case SyntaxNodeType::Return: {
         auto return_stmt = std::dynamic_pointer_cast<Return>(tree);
         auto expr = TRY_AND_CAST(Expression, return_stmt->expression(), ctx);
-        ret = std::make_shared<Return>(return_stmt->location(), expr, return_stmt->return_error());
+        ret = make_node<Return>(return_stmt->location(), expr, return_stmt->return_error());
         break;
     }
 
     case SyntaxNodeType::BoundReturn: {
         auto return_stmt = std::dynamic_pointer_cast<BoundReturn>(tree);
         auto expr = TRY_AND_CAST(BoundExpression, return_stmt->expression(), ctx);
-        ret = std::make_shared<BoundReturn>(return_stmt, expr, return_stmt->return_error());
+        ret = make_node<BoundReturn>(return_stmt, expr, return_stmt->return_error());
         break;
     }
 
@@ -510,7 +524,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         if (branch->condition())
             condition = TRY_AND_CAST(Expression, branch->condition(), ctx);
         auto statement = TRY_AND_CAST(Statement, branch->statement(), ctx);
-        ret = std::make_shared<Branch>(branch, condition, statement);
+        ret = make_node<Branch>(branch, condition, statement);
         break;
     }
 
@@ -520,7 +534,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         if (branch->condition())
             condition = TRY_AND_CAST(BoundExpression, branch->condition(), ctx);
         auto statement = TRY_AND_CAST(Statement, branch->statement(), ctx);
-        ret = std::make_shared<BoundBranch>(branch, condition, statement);
+        ret = make_node<BoundBranch>(branch, condition, statement);
         break;
     }
 
@@ -532,7 +546,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             if (branch_maybe.has_value())
                 branches.push_back(std::dynamic_pointer_cast<Branch>(branch_maybe.value()));
         }
-        ret = std::make_shared<IfStatement>(if_stmt->location(), branches);
+        ret = make_node<IfStatement>(if_stmt->location(), branches);
         break;
     }
 
@@ -543,7 +557,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             auto branch_processed = TRY_AND_CAST(BoundBranch, branch, ctx);
             branches.push_back(branch_processed);
         }
-        ret = std::make_shared<BoundIfStatement>(if_stmt->location(), branches);
+        ret = make_node<BoundIfStatement>(if_stmt->location(), branches);
         break;
     }
 
@@ -552,7 +566,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto condition = TRY_AND_CAST(Expression, while_stmt->condition(), ctx);
         auto stmt = TRY_AND_CAST(Statement, while_stmt->statement(), ctx);
         if ((condition != while_stmt->condition()) || (stmt != while_stmt->statement()))
-            ret = std::make_shared<WhileStatement>(while_stmt->location(), condition, stmt);
+            ret = make_node<WhileStatement>(while_stmt->location(), condition, stmt);
         break;
     }
 
@@ -561,7 +575,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto condition = TRY_AND_CAST(BoundExpression, while_stmt->condition(), ctx);
         auto stmt = TRY_AND_CAST(Statement, while_stmt->statement(), ctx);
         if ((condition != while_stmt->condition()) || (stmt != while_stmt->statement()))
-            ret = std::make_shared<BoundWhileStatement>(while_stmt, condition, stmt);
+            ret = make_node<BoundWhileStatement>(while_stmt, condition, stmt);
         break;
     }
 
@@ -570,7 +584,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto variable = TRY_AND_CAST(Variable, for_stmt->variable(), ctx);
         auto range = TRY_AND_CAST(Expression, for_stmt->range(), ctx);
         auto stmt = TRY_AND_CAST(Statement, for_stmt->statement(), ctx);
-        ret = std::make_shared<ForStatement>(for_stmt->location(), variable, range, stmt);
+        ret = make_node<ForStatement>(for_stmt->location(), variable, range, stmt);
         break;
     }
 
@@ -579,7 +593,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         auto variable = TRY_AND_CAST(BoundVariable, for_stmt->variable(), ctx);
         auto range = TRY_AND_CAST(BoundExpression, for_stmt->range(), ctx);
         auto stmt = TRY_AND_CAST(Statement, for_stmt->statement(), ctx);
-        ret = std::make_shared<BoundForStatement>(for_stmt, variable, range, stmt);
+        ret = make_node<BoundForStatement>(for_stmt, variable, range, stmt);
         break;
     }
 
@@ -589,7 +603,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         if (stmt->condition())
             condition = TRY_AND_CAST(Expression, stmt->condition(), ctx);
         auto statement = TRY_AND_CAST(Statement, stmt->statement(), ctx);
-        ret = std::make_shared<CaseStatement>(stmt, condition, statement);
+        ret = make_node<CaseStatement>(stmt, condition, statement);
         break;
     }
 
@@ -599,7 +613,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         if (stmt->condition())
             condition = TRY_AND_CAST(Expression, stmt->condition(), ctx);
         auto statement = TRY_AND_CAST(Statement, stmt->statement(), ctx);
-        ret = std::make_shared<DefaultCase>(stmt, condition, statement);
+        ret = make_node<DefaultCase>(stmt, condition, statement);
         break;
     }
 
@@ -611,7 +625,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             cases.push_back(TRY_AND_CAST(CaseStatement, case_stmt, ctx));
         }
         auto default_case = TRY_AND_CAST(DefaultCase, switch_stmt->default_case(), ctx);
-        ret = std::make_shared<SwitchStatement>(switch_stmt->location(), expr, cases, default_case);
+        ret = make_node<SwitchStatement>(switch_stmt->location(), expr, cases, default_case);
         break;
     }
 
@@ -623,7 +637,7 @@ ErrorOrNode process_tree(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
             cases.push_back(TRY_AND_CAST(BoundBranch, case_stmt, ctx));
         }
         auto default_case = TRY_AND_CAST(BoundBranch, switch_stmt->default_case(), ctx);
-        ret = std::make_shared<BoundSwitchStatement>(switch_stmt, expr, cases, default_case);
+        ret = make_node<BoundSwitchStatement>(switch_stmt, expr, cases, default_case);
         break;
     }
 
@@ -656,7 +670,7 @@ ErrorOrNode process_block(std::shared_ptr<SyntaxNode> const& tree, Context& ctx,
         }
     }
     if (statements != block->statements())
-        return std::make_shared<StmtClass>(tree->location(), statements, std::forward<Args>(args)...);
+        return make_node<StmtClass>(tree->location(), statements, std::forward<Args>(args)...);
     else
         return tree;
 }
@@ -693,23 +707,31 @@ ProcessResult& process(std::shared_ptr<SyntaxNode> const& tree, Ctx& ctx, Proces
         return result;
     }
     std::string log_message;
-    debug(processor, "Process <{} {}>", tree->node_type(), tree);
+    auto trace = processor_trace_enabled();
+    if (trace) {
+        debug(processor, "Process <{} {}>", tree->node_type(), tree);
+    }
     switch (tree->node_type()) {
 #undef ENUM_SYNTAXNODETYPE
-#define ENUM_SYNTAXNODETYPE(type)                                                           \
-    case SyntaxNodeType::type: {                                                            \
-        log_message = format("<{} {}> => ", #type, tree);                                   \
-        ErrorOrNode processed = process_node<Ctx, SyntaxNodeType::type>(tree, ctx, result); \
-        if (processed.is_error()) {                                                         \
-            log_message += format("Error {}", processed.error());                           \
-            result.error(processed.error());                                                \
-            result = tree;                                                                  \
-        } else {                                                                            \
-            result = processed.value();                                                     \
-            log_message += format("<{} {}>", result.value()->node_type(), result.value());  \
-        }                                                                                   \
-        debug(processor, "{}", log_message);                                                \
-        return result;                                                                      \
+#define ENUM_SYNTAXNODETYPE(type)                                                              \
+    case SyntaxNodeType::type: {                                                               \
+        if (trace)                                                                             \
+            log_message = format("<{} {}> => ", #type, tree);                                  \
+        ErrorOrNode processed = process_node<Ctx, SyntaxNodeType::type>(tree, ctx, result);    \
+        if (processed.is_error()) {                                                            \
+            if (trace)                                                                         \
+                log_message += format("Error {}", processed.error());                          \
+            result.error(processed.error());                                                   \
+            result = tree;                                                                     \
+        } else {                                                                               \
+            result = processed.value();                                                        \
+            if (trace)                                                                         \
+                log_message += format("<{} {}>", result.value()->node_type(), result.value()); \
+        }                                                                                      \
+        if (trace) {                                                                           \
+            debug(processor, "{}", log_message);                                               \
+        }                                                                                      \
+        return result;                                                                         \
     }
         ENUMERATE_SYNTAXNODETYPES(ENUM_SYNTAXNODETYPE)
 #undef ENUM_SYNTAXNODETYPE
@@ -736,7 +758,9 @@ ProcessResult process(std::shared_ptr<SyntaxNode> const& tree, Ctx& ctx)
 template<typename Ctx, SyntaxNodeType node_type>
 ErrorOrNode process_node(std::shared_ptr<SyntaxNode> const& tree, Ctx& ctx, ProcessResult& result)
 {
-    debug(processor, "Falling back to default processor for type {}", tree->node_type());
+    if (processor_trace_enabled()) {
+        debug(processor, "Falling back to default processor for type {}", tree->node_type());
+    }
     return process_tree(tree, ctx, result, [](std::shared_ptr<SyntaxNode> const& tree, Ctx& ctx, ProcessResult& result) {
         return process(tree, ctx, result);
     });
@@ -47,7 +47,7 @@ NODE_PROCESSOR(BoundUnaryExpression)
         break;
     }
     }
-    return TRY(process(std::make_shared<BoundIntrinsicCall>(expr->location(), std::dynamic_pointer_cast<BoundIntrinsicDecl>(decl), BoundExpressions { operand }, intrinsic), ctx, result));
+    return TRY(process(make_node<BoundIntrinsicCall>(expr->location(), std::dynamic_pointer_cast<BoundIntrinsicDecl>(decl), BoundExpressions { operand }, intrinsic), ctx, result));
 }
 
 NODE_PROCESSOR(BoundBinaryExpression)
@@ -68,20 +68,20 @@ NODE_PROCESSOR(BoundBinaryExpression)
             auto offset_val = offset_literal->value();
             if (expr->op() == BinaryOperator::Subtract)
                 offset_val *= -1;
-            offset = std::make_shared<BoundIntLiteral>(rhs->location(), target_type->size() * offset_val);
+            offset = make_node<BoundIntLiteral>(rhs->location(), target_type->size() * offset_val);
         } else {
             offset = rhs;
             if (expr->op() == BinaryOperator::Subtract)
-                offset = std::make_shared<BoundUnaryExpression>(expr->location(), offset, UnaryOperator::Negate, expr->type());
-            auto size = std::make_shared<BoundIntLiteral>(rhs->location(), target_type->size());
-            offset = TRY_AND_CAST(BoundExpression, std::make_shared<BoundBinaryExpression>(expr->location(), size, BinaryOperator::Multiply, offset, ObjectType::get("u64")), ctx);
+                offset = make_node<BoundUnaryExpression>(expr->location(), offset, UnaryOperator::Negate, expr->type());
+            auto size = make_node<BoundIntLiteral>(rhs->location(), target_type->size());
+            offset = TRY_AND_CAST(BoundExpression, make_node<BoundBinaryExpression>(expr->location(), size, BinaryOperator::Multiply, offset, ObjectType::get("u64")), ctx);
         }
-        auto ident = std::make_shared<BoundIdentifier>(Span {}, BinaryOperator_name(expr->op()), lhs->type());
+        auto ident = make_node<BoundIdentifier>(Span {}, BinaryOperator_name(expr->op()), lhs->type());
         BoundIdentifiers params;
-        params.push_back(std::make_shared<BoundIdentifier>(Span {}, "ptr", lhs->type()));
-        params.push_back(std::make_shared<BoundIdentifier>(Span {}, "offset", ObjectType::get("s32")));
-        auto decl = std::make_shared<BoundIntrinsicDecl>("/", ident, params);
-        return TRY(process(std::make_shared<BoundIntrinsicCall>(expr->location(), decl, BoundExpressions { lhs, offset }, IntrinsicType::ptr_math), ctx, result));
+        params.push_back(make_node<BoundIdentifier>(Span {}, "ptr", lhs->type()));
+        params.push_back(make_node<BoundIdentifier>(Span {}, "offset", ObjectType::get("s32")));
+        auto decl = make_node<BoundIntrinsicDecl>("/", ident, params);
+        return TRY(process(make_node<BoundIntrinsicCall>(expr->location(), decl, BoundExpressions { lhs, offset }, IntrinsicType::ptr_math), ctx, result));
     }
 
     if ((rhs->node_type() == SyntaxNodeType::BoundIntLiteral) && (rhs->type()->type() == lhs->type()->type()) && (rhs->type()->size() > lhs->type()->size()))
@@ -97,8 +97,8 @@ NODE_PROCESSOR(BoundBinaryExpression)
     auto intrinsic = impl.intrinsic;
     auto decl = method_descr->declaration();
     if (auto intrinsic_decl = std::dynamic_pointer_cast<BoundIntrinsicDecl>(decl); intrinsic_decl != nullptr)
-        return TRY(process(std::make_shared<BoundIntrinsicCall>(expr->location(), intrinsic_decl, BoundExpressions { lhs, rhs }, intrinsic), ctx));
-    return TRY(process(std::make_shared<BoundFunctionCall>(expr->location(), decl, BoundExpressions { lhs, rhs }), ctx));
+        return TRY(process(make_node<BoundIntrinsicCall>(expr->location(), intrinsic_decl, BoundExpressions { lhs, rhs }, intrinsic), ctx));
+    return TRY(process(make_node<BoundFunctionCall>(expr->location(), decl, BoundExpressions { lhs, rhs }), ctx));
 }
 
 ProcessResult& resolve_operators(ProcessResult& result)
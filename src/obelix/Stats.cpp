@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sys/resource.h>
+
+#include <obelix/BoundSyntaxNode.h>
+#include <obelix/Stats.h>
+#include <obelix/Syntax.h>
+
+namespace Obelix {
+
+static size_t count_nodes(pSyntaxNode const& node)
+{
+    if (node == nullptr)
+        return 0;
+    // NodeLists are created on the fly by children(); they're not part of the tree.
+    size_t ret = (node->node_type() != SyntaxNodeType::NodeList) ? 1 : 0;
+    for (auto const& child : node->children())
+        ret += count_nodes(child);
+    return ret;
+}
+
+static long peak_rss_kb()
+{
+    struct rusage usage { };
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Reported in bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+static std::string json_string(std::string const& s)
+{
+    std::string ret = "\"";
+    for (auto ch : s) {
+        switch (ch) {
+        case '"':
+        case '\\':
+            ret += '\\';
+            ret += ch;
+            break;
+        case '\n':
+            ret += "\\n";
+            break;
+        case '\t':
+            ret += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                ret += buf;
+            } else {
+                ret += ch;
+            }
+        }
+    }
+    return ret + "\"";
+}
+
+CompilerStats& CompilerStats::get_stats()
+{
+    static CompilerStats s_stats;
+    return s_stats;
+}
+
+void CompilerStats::enable()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = true;
+    m_total.reset();
+}
+
+void CompilerStats::add_phase(std::string const& phase, Stopwatch const& stopwatch, pSyntaxNode const& tree)
+{
+    if (!m_enabled)
+        return;
+    PhaseStats stats { phase, stopwatch.elapsed() };
+    stats.nodes = count_nodes(tree);
+    if (auto compilation = std::dynamic_pointer_cast<Compilation>(tree); compilation != nullptr) {
+        for (auto const& module : compilation->modules())
+            stats.modules.push_back({ module->name(), count_nodes(module) });
+    } else if (auto bound_compilation = std::dynamic_pointer_cast<BoundCompilation>(tree); bound_compilation != nullptr) {
+        for (auto const& module : bound_compilation->modules())
+            stats.modules.push_back({ module->name(), count_nodes(module) });
+    }
+    stats.peak_rss_kb = peak_rss_kb();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_phases.push_back(std::move(stats));
+}
+
+void CompilerStats::add_module_time(std::string const& phase, std::string const& module, Stopwatch const& stopwatch)
+{
+    if (!m_enabled)
+        return;
+    auto seconds = stopwatch.elapsed();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_module_times.push_back({ phase, ModuleStats { module, 0, seconds } });
+}
+
+void CompilerStats::add_process(std::string const& phase, std::string const& module, std::string const& command, Stopwatch const& stopwatch, int exit_code)
+{
+    if (!m_enabled)
+        return;
+    auto seconds = stopwatch.elapsed();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_processes.push_back({ phase, module, command, seconds, exit_code });
+}
+
+// Merges the per-module node counts of a phase with the per-module timings
+// recorded for it.
+std::vector<CompilerStats::ModuleStats> CompilerStats::modules_of(PhaseStats const& phase) const
+{
+    auto ret = phase.modules;
+    for (auto const& [phase_name, timing] : m_module_times) {
+        if (phase_name != phase.phase)
+            continue;
+        auto it = std::find_if(ret.begin(), ret.end(), [&timing](ModuleStats const& m) { return m.module == timing.module; });
+        if (it != ret.end())
+            it->seconds = timing.seconds;
+        else
+            ret.push_back(timing);
+    }
+    return ret;
+}
+
+void CompilerStats::report(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto flags = os.flags();
+    os << std::fixed << std::setprecision(3);
+    os << "\n"
+       << std::left << std::setw(20) << "Phase" << std::right << std::setw(12) << "Time (s)" << std::setw(12) << "Nodes" << std::setw(16) << "Peak RSS (KB)" << "\n";
+    for (auto const& phase : m_phases) {
+        os << std::left << std::setw(20) << phase.phase << std::right << std::setw(12) << phase.seconds << std::setw(12) << phase.nodes << std::setw(16) << phase.peak_rss_kb << "\n";
+        for (auto const& module : modules_of(phase)) {
+            os << "    " << std::left << std::setw(16) << module.module << std::right << std::setw(12);
+            if (module.seconds >= 0.0)
+                os << module.seconds;
+            else
+                os << "";
+            os << std::setw(12) << module.nodes << "\n";
+        }
+    }
+    if (!m_processes.empty()) {
+        os << "\n"
+           << std::left << std::setw(20) << "Process" << std::right << std::setw(12) << "Time (s)" << std::setw(12) << "Exit code" << "\n";
+        for (auto const& process : m_processes) {
+            auto name = process.module.empty() ? process.phase : process.phase + " " + process.module;
+            os << std::left << std::setw(20) << name << std::right << std::setw(12) << process.seconds << std::setw(12) << process.exit_code << "\n";
+        }
+    }
+    os << "\nTotal: " << m_total.elapsed() << "s, peak RSS " << peak_rss_kb() << " KB\n";
+    os.flags(flags);
+}
+
+void CompilerStats::write_json(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    os << "{\n  \"total_seconds\": " << m_total.elapsed() << ",\n  \"peak_rss_kb\": " << peak_rss_kb() << ",\n  \"phases\": [";
+    auto first_phase = true;
+    for (auto const& phase : m_phases) {
+        os << (first_phase ? "\n" : ",\n") << "    { \"phase\": " << json_string(phase.phase) << ", \"seconds\": " << phase.seconds
+           << ", \"nodes\": " << phase.nodes << ", \"peak_rss_kb\": " << phase.peak_rss_kb << ", \"modules\": [";
+        auto first_module = true;
+        for (auto const& module : modules_of(phase)) {
+            os << (first_module ? " " : ", ") << "{ \"module\": " << json_string(module.module) << ", \"nodes\": " << module.nodes;
+            if (module.seconds >= 0.0)
+                os << ", \"seconds\": " << module.seconds;
+            os << " }";
+            first_module = false;
+        }
+        os << " ] }";
+        first_phase = false;
+    }
+    os << "\n  ],\n  \"processes\": [";
+    auto first_process = true;
+    for (auto const& process : m_processes) {
+        os << (first_process ? "\n" : ",\n") << "    { \"phase\": " << json_string(process.phase) << ", \"module\": " << json_string(process.module)
+           << ", \"command\": " << json_string(process.command) << ", \"seconds\": " << process.seconds << ", \"exit_code\": " << process.exit_code << " }";
+        first_process = false;
+    }
+    os << "\n  ]\n}\n";
+}
+
+}
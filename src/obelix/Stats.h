@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <obelix/syntax/Forward.h>
+
+namespace Obelix {
+
+class Stopwatch {
+public:
+    Stopwatch() = default;
+
+    void reset() { m_start = std::chrono::steady_clock::now(); }
+
+    [[nodiscard]] double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start { std::chrono::steady_clock::now() };
+};
+
+// Wall time, node counts and peak memory use of the phases of a compilation,
+// and the time spent in the external processes it runs. Collected when the
+// compiler is run with --stats or --stats-json=<file>. Can be fed from
+// concurrent jobs.
+class CompilerStats {
+public:
+    struct ModuleStats {
+        std::string module;
+        size_t nodes { 0 };
+        double seconds { -1.0 };
+    };
+
+    struct PhaseStats {
+        std::string phase;
+        double seconds { 0.0 };
+        size_t nodes { 0 };
+        long peak_rss_kb { 0 };
+        std::vector<ModuleStats> modules {};
+    };
+
+    struct ProcessStats {
+        std::string phase;
+        std::string module;
+        std::string command;
+        double seconds { 0.0 };
+        int exit_code { -1 };
+    };
+
+    static CompilerStats& get_stats();
+
+    void enable();
+    [[nodiscard]] bool enabled() const { return m_enabled; }
+
+    void add_phase(std::string const& phase, Stopwatch const&, pSyntaxNode const& tree = nullptr);
+    void add_module_time(std::string const& phase, std::string const& module, Stopwatch const&);
+    void add_process(std::string const& phase, std::string const& module, std::string const& command, Stopwatch const&, int exit_code);
+
+    void report(std::ostream&) const;
+    void write_json(std::ostream&) const;
+
+private:
+    CompilerStats() = default;
+
+    [[nodiscard]] std::vector<ModuleStats> modules_of(PhaseStats const&) const;
+
+    mutable std::mutex m_mutex;
+    bool m_enabled { false };
+    Stopwatch m_total;
+    std::vector<PhaseStats> m_phases;
+    std::vector<std::pair<std::string, ModuleStats>> m_module_times;
+    std::vector<ProcessStats> m_processes;
+};
+
+}
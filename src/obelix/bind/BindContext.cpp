@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
+
 #include <obelix/bind/BindContext.h>
 
 namespace Obelix {
@@ -262,9 +264,10 @@ ObjectTypes const& RootContext::custom_types() const
     return m_custom_types;
 }
 
-void RootContext::add_unresolved(pExpression expr)
+void RootContext::add_unresolved(pExpression expr, PendingBinding pending)
 {
     m_unresolved.push_back(std::move(expr));
+    add_pending(std::move(pending));
 }
 
 Expressions const& RootContext::unresolved() const
@@ -275,6 +278,57 @@ Expressions const& RootContext::unresolved() const
 void RootContext::clear_unresolved()
 {
     m_unresolved.clear();
+    m_pending.clear();
+}
+
+void RootContext::add_pending(PendingBinding pending)
+{
+    m_pending.push_back(std::move(pending));
+}
+
+bool RootContext::has_pending(std::string const& module, std::string const& scope) const
+{
+    return std::any_of(m_pending.begin(), m_pending.end(), [&module, &scope](PendingBinding const& pending) {
+        return pending.module == module && pending.scope == scope;
+    });
+}
+
+void RootContext::add_declared_name(std::string const& name)
+{
+    m_declared_names.insert(name);
+}
+
+void RootContext::start_pass(bool full_pass)
+{
+    m_full_pass = full_pass;
+    m_rebind_scopes.clear();
+    m_unresolved.clear();
+    if (full_pass) {
+        m_pending.clear();
+    } else {
+        // Scopes waiting for a name declared in the previous pass are rebound.
+        // The others are skipped in this pass, so their pending bindings are
+        // kept around for the next one.
+        std::vector<PendingBinding> waiting;
+        for (auto& pending : m_pending) {
+            auto ready = pending.dependencies.empty() || std::any_of(pending.dependencies.begin(), pending.dependencies.end(), [this](std::string const& name) {
+                return m_declared_names.contains(name);
+            });
+            if (ready) {
+                m_rebind_scopes.emplace(pending.module, pending.scope);
+                m_rebind_scopes.emplace(pending.module, "");
+            } else {
+                waiting.push_back(std::move(pending));
+            }
+        }
+        m_pending = std::move(waiting);
+    }
+    m_declared_names.clear();
+}
+
+bool RootContext::must_rebind(std::string const& module, std::string const& scope) const
+{
+    return m_full_pass || m_rebind_scopes.contains({ module, scope });
 }
 
 void RootContext::add_module(pBoundModule const& module)
@@ -364,6 +418,7 @@ BindContext& BindContext::make_subcontext()
     auto& sub = m_children.emplace_back(BindContextType::SubContext);
     sub.m_impl = std::make_shared<SubContext>(impl());
     sub.return_type = return_type;
+    sub.function_scope = function_scope;
     m_impl->m_child_impls.push_back(sub.m_impl);
     return sub;
 }
@@ -412,8 +467,17 @@ std::string BindContext::scope_name() const
     fatal("Unreachable");
 }
 
+std::string BindContext::module_name() const
+{
+    auto module = m_impl->module_impl();
+    if (module == nullptr)
+        return "";
+    return module->name();
+}
+
 void BindContext::add_custom_type(pObjectType type)
 {
+    m_impl->root_impl()->add_declared_name(type->name());
     m_impl->root_impl()->add_custom_type(std::move(type));
 }
 
@@ -424,7 +488,9 @@ ObjectTypes const& BindContext::custom_types() const
 
 ErrorOr<void, SyntaxError> BindContext::declare(std::string const& name, Obelix::pBoundVariableDeclaration const& decl)
 {
-    return impl()->declare(name, decl);
+    TRY_RETURN(impl()->declare(name, decl));
+    m_impl->root_impl()->add_declared_name(name);
+    return {};
 }
 
 std::optional<pBoundVariableDeclaration> BindContext::get(std::string const& name) const
@@ -432,9 +498,25 @@ std::optional<pBoundVariableDeclaration> BindContext::get(std::string const& nam
     return impl()->get(name);
 }
 
+static void collect_names(pSyntaxNode const& node, std::set<std::string>& names)
+{
+    if (node == nullptr)
+        return;
+    if (auto identifier = std::dynamic_pointer_cast<Identifier>(node); identifier != nullptr)
+        names.insert(identifier->name());
+    if (auto type = std::dynamic_pointer_cast<ExpressionType>(node); type != nullptr)
+        names.insert(type->type_name());
+    if (auto expr = std::dynamic_pointer_cast<Expression>(node); expr != nullptr)
+        collect_names(expr->type(), names);
+    for (auto const& child : node->children())
+        collect_names(child, names);
+}
+
 void BindContext::add_unresolved(pExpression expr)
 {
-    m_impl->root_impl()->add_unresolved(std::move(expr));
+    PendingBinding pending { module_name(), function_scope, {} };
+    collect_names(expr, pending.dependencies);
+    m_impl->root_impl()->add_unresolved(std::move(expr), std::move(pending));
 }
 
 Expressions const& BindContext::unresolved() const
@@ -447,9 +529,41 @@ void BindContext::clear_unresolved()
     m_impl->root_impl()->clear_unresolved();
 }
 
+// Called when a scope ends up not fully bound without having recorded an
+// unresolved expression, for example because a variable is referenced before
+// its declaration was bound. Such scopes are retried in every pass.
+void BindContext::mark_unbound()
+{
+    auto root = m_impl->root_impl();
+    auto module = module_name();
+    if (!root->has_pending(module, function_scope))
+        root->add_pending({ module, function_scope, {} });
+}
+
+void BindContext::start_pass(bool full_pass)
+{
+    m_impl->root_impl()->start_pass(full_pass);
+}
+
+bool BindContext::must_rebind() const
+{
+    return m_impl->root_impl()->must_rebind(module_name(), function_scope);
+}
+
+bool BindContext::must_rebind_scope(std::string const& scope) const
+{
+    return m_impl->root_impl()->must_rebind(module_name(), scope);
+}
+
+bool BindContext::must_rebind_module(std::string const& module) const
+{
+    return m_impl->root_impl()->must_rebind(module, "");
+}
+
 void BindContext::add_declared_function(std::string const& name, pBoundFunctionDecl const& func)
 {
     m_impl->module_impl()->add_declared_function(name, func);
+    m_impl->root_impl()->add_declared_name(name);
 }
 
 FunctionRegistry const& BindContext::declared_functions() const
@@ -460,6 +574,7 @@ FunctionRegistry const& BindContext::declared_functions() const
 void BindContext::add_exported_variable(std::string const& name, Obelix::pBoundVariableDeclaration const& variable)
 {
     m_impl->module_impl()->add_declared_variable(name, variable);
+    m_impl->root_impl()->add_declared_name(name);
 }
 
 VariableRegistry const& BindContext::exported_variables() const
@@ -497,6 +612,7 @@ BoundStatements BindContext::exports() const
 
 void BindContext::add_module(pBoundModule const& module)
 {
+    m_impl->root_impl()->add_declared_name(module->name());
     m_impl->root_impl()->add_module(module);
 }
 
@@ -513,6 +629,7 @@ pBoundStructDefinition BindContext::struct_definition(std::string const& name)
 void BindContext::set_struct_definition(pBoundStructDefinition struct_def)
 {
     assert(m_impl->type() == BindContextType::StructContext);
+    m_impl->root_impl()->add_declared_name(struct_def->name());
     std::dynamic_pointer_cast<StructContext>(m_impl)->struct_definition = std::move(struct_def);
 }
 
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <map>
+#include <set>
 
 #include <obelix/BoundSyntaxNode.h>
 #include <obelix/Context.h>
@@ -157,15 +158,31 @@ private:
     BoundStatements m_imports;
 };
 
+// An expression that could not be bound yet, together with the names it
+// references. The scope is the function whose body contains the expression,
+// or empty for module level statements. A scope is only rebound in the next
+// pass if one of the names it waits for was declared in the current pass.
+// Pending bindings without dependencies are always retried.
+struct PendingBinding {
+    std::string module;
+    std::string scope;
+    std::set<std::string> dependencies;
+};
+
 class RootContext : public ExportsFunctions {
 public:
     RootContext(pContextImpl);
 
     void add_custom_type(pObjectType);
     [[nodiscard]] ObjectTypes const& custom_types() const;
-    void add_unresolved(pExpression);
+    void add_unresolved(pExpression, PendingBinding);
     [[nodiscard]] Expressions const& unresolved() const;
     void clear_unresolved();
+    void add_pending(PendingBinding);
+    [[nodiscard]] bool has_pending(std::string const& module, std::string const& scope) const;
+    void add_declared_name(std::string const&);
+    void start_pass(bool full_pass);
+    [[nodiscard]] bool must_rebind(std::string const& module, std::string const& scope) const;
     void add_module(pBoundModule const& module);
     [[nodiscard]] pBoundModule module(std::string const& name) const;
     [[nodiscard]] pModuleContext module_context(std::string const& name);
@@ -179,6 +196,10 @@ public:
 private:
     ObjectTypes m_custom_types;
     Expressions m_unresolved;
+    std::vector<PendingBinding> m_pending;
+    std::set<std::string> m_declared_names;
+    std::set<std::pair<std::string, std::string>> m_rebind_scopes;
+    bool m_full_pass { true };
     std::unordered_map<std::string, pBoundModule> m_modules;
     ModuleContexts m_module_contexts;
     std::unordered_map<std::string, pBoundStructDefinition> m_structs;
@@ -202,6 +223,11 @@ public:
     void add_unresolved(pExpression);
     [[nodiscard]] Expressions const& unresolved() const;
     void clear_unresolved();
+    void mark_unbound();
+    void start_pass(bool full_pass);
+    [[nodiscard]] bool must_rebind() const;
+    [[nodiscard]] bool must_rebind_scope(std::string const&) const;
+    [[nodiscard]] bool must_rebind_module(std::string const&) const;
     void add_declared_function(std::string const&, pBoundFunctionDecl const&);
     [[nodiscard]] FunctionRegistry const& declared_functions() const;
     void add_exported_variable(std::string const&, pBoundVariableDeclaration const&);
@@ -223,6 +249,7 @@ public:
     void dump() const;
 
     pObjectType return_type { nullptr };
+    std::string function_scope {};
     int stage { 0 };
 
 protected:
@@ -231,6 +258,8 @@ protected:
     [[nodiscard]] pContextImpl impl() { return m_impl; }
 
 private:
+    [[nodiscard]] std::string module_name() const;
+
     pContextImpl m_impl;
     std::vector<BindContext> m_children {};
 };
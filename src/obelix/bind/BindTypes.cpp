@@ -10,6 +10,7 @@
 #include <obelix/Context.h>
 #include <obelix/Intrinsics.h>
 #include <obelix/Processor.h>
+#include <obelix/Stats.h>
 #include <obelix/bind/BindContext.h>
 #include <obelix/parser/Parser.h>
 
@@ -58,7 +59,7 @@ ErrorOr<std::shared_ptr<BoundExpression>, SyntaxError> make_function_call(BindCo
                         auto bound_method = std::dynamic_pointer_cast<BoundFunctionDef>(method);
                         auto bound_method_decl = std::dynamic_pointer_cast<BoundMethodDecl>(bound_method->declaration());
                         if (bound_method_decl->method() == method_description)
-                            return std::make_shared<BoundMethodCall>(function->location(), bound_method_decl, member_access->structure(), args);
+                            return make_node<BoundMethodCall>(function->location(), bound_method_decl, member_access->structure(), args);
                     }
                 }
             }
@@ -71,7 +72,7 @@ ErrorOr<std::shared_ptr<BoundExpression>, SyntaxError> make_function_call(BindCo
             for (auto const& arg : arguments->expressions()) {
                 arg_list_with_this.push_back(arg);
             }
-            return make_function_call(ctx, member_access->member(), std::make_shared<BoundExpressionList>(arguments->location(), arg_list_with_this));
+            return make_function_call(ctx, member_access->member(), make_node<BoundExpressionList>(arguments->location(), arg_list_with_this));
         }
         }
     }
@@ -83,12 +84,12 @@ ErrorOr<std::shared_ptr<BoundExpression>, SyntaxError> make_function_call(BindCo
         auto intrinsic = IntrinsicType_by_name(declaration->name());
         if (intrinsic == IntrinsicType::NotIntrinsic)
             return SyntaxError { function->location(), "Intrinsic {} not defined", declaration->name() };
-        return std::make_shared<BoundIntrinsicCall>(function->location(), std::dynamic_pointer_cast<BoundIntrinsicDecl>(declaration), args, intrinsic);
+        return make_node<BoundIntrinsicCall>(function->location(), std::dynamic_pointer_cast<BoundIntrinsicDecl>(declaration), args, intrinsic);
     }
     case SyntaxNodeType::BoundNativeFunctionDecl:
-        return std::make_shared<BoundNativeFunctionCall>(function->location(), std::dynamic_pointer_cast<BoundNativeFunctionDecl>(declaration), args);
+        return make_node<BoundNativeFunctionCall>(function->location(), std::dynamic_pointer_cast<BoundNativeFunctionDecl>(declaration), args);
     default:
-        return std::make_shared<BoundFunctionCall>(function->location(), declaration, args);
+        return make_node<BoundFunctionCall>(function->location(), declaration, args);
     }
 }
 
@@ -125,8 +126,8 @@ ErrorOr<pBoundExpression, SyntaxError> make_expression_for_assignment(pBoundExpr
             if (!member_type->is_assignable_to(desired_type))
                 return SyntaxError { expr->location(), "Cannot assign '{}' which has type '{}' to type '{}'", expr->to_string(), expr->type(), desired_type };
         }
-        auto member_identifier = std::make_shared<BoundIdentifier>(expr->location(), member, member_type);
-        return std::make_shared<BoundMemberAccess>(expr, member_identifier);
+        auto member_identifier = make_node<BoundIdentifier>(expr->location(), member, member_type);
+        return make_node<BoundMemberAccess>(expr, member_identifier);
     }
 
     // var x: type_a/type_b
@@ -143,7 +144,7 @@ ErrorOr<pBoundExpression, SyntaxError> make_expression_for_assignment(pBoundExpr
         }
         if (new_expr == nullptr)
             return SyntaxError { expr->location(), "Cannot assign '{}' which has type '{}' to type '{}'", expr->to_string(), expr->type(), desired_type };
-        return std::make_shared<BoundConditionalValue>(new_expr->location(), new_expr, success, desired_type);
+        return make_node<BoundConditionalValue>(new_expr->location(), new_expr, success, desired_type);
     }
 
     if (desired_type != nullptr) {
@@ -167,7 +168,7 @@ ErrorOrTypedNode<Statement> process_branch(std::shared_ptr<Branch> const& branch
     auto statement_processed = statement_processed_maybe.value();
     if (statement_processed == nullptr || !statement_processed->is_fully_bound())
         return branch;
-    return std::make_shared<BoundBranch>(branch->location(), bound_condition, statement_processed);
+    return make_node<BoundBranch>(branch->location(), bound_condition, statement_processed);
 }
 
 #define PROCESS_BRANCH(tree, branch, ctx)                                                    \
@@ -218,7 +219,7 @@ NODE_PROCESSOR(StructDefinition)
             return SyntaxError { struct_def->location(), field_type_maybe.error().message() };
         }
         auto field_type = field_type_maybe.value();
-        auto bound_field_name = std::make_shared<BoundIdentifier>(field, field_type);
+        auto bound_field_name = make_node<BoundIdentifier>(field, field_type);
         bound_fields.push_back(bound_field_name);
         field_defs.emplace_back(field->name(), field_type);
     }
@@ -247,13 +248,13 @@ NODE_PROCESSOR(StructDefinition)
         if (method_descr == nullptr)
             method_descr = type->add_method(MethodDescription(bound_method->name(), bound_method->type(), params));
         // FIXME if a matching method is found, check the return type
-        bound_methods.push_back(std::make_shared<BoundFunctionDef>(method->location(),
-            std::make_shared<BoundMethodDecl>(method->declaration(), method_descr),
+        bound_methods.push_back(make_node<BoundFunctionDef>(method->location(),
+            make_node<BoundMethodDecl>(method->declaration(), method_descr),
             bound_method->statement()));
     }
     if (!resolved)
         return tree;
-    auto ret = std::make_shared<BoundStructDefinition>(struct_def, type, bound_fields, bound_methods);
+    auto ret = make_node<BoundStructDefinition>(struct_def, type, bound_fields, bound_methods);
     struct_ctx.set_struct_definition(ret);
     return ret;
 }
@@ -269,7 +270,7 @@ NODE_PROCESSOR(EnumDef)
             // FIXME Check sanity of value
             v = value->value().value();
         enum_values.emplace_back(value->label(), v);
-        bound_values.push_back(std::make_shared<BoundEnumValueDef>(value->location(), value->label(), v));
+        bound_values.push_back(make_node<BoundEnumValueDef>(value->location(), value->label(), v));
         v++;
     }
     std::shared_ptr<ObjectType> type;
@@ -282,7 +283,7 @@ NODE_PROCESSOR(EnumDef)
             return SyntaxError { enum_def->location(), "Cannot extend non-existing enum '{}'", enum_def->name() };
         TRY_RETURN(type->extend_enum_type(enum_values));
     }
-    return std::make_shared<BoundEnumDef>(enum_def, type, bound_values);
+    return make_node<BoundEnumDef>(enum_def, type, bound_values);
 }
 
 NODE_PROCESSOR(ExpressionType)
@@ -291,7 +292,7 @@ NODE_PROCESSOR(ExpressionType)
     auto type_maybe = type->resolve_type();
     if (type_maybe.is_error())
         return SyntaxError { tree->location(), type_maybe.error().message() };
-    return std::make_shared<BoundType>(type->location(), type_maybe.value());
+    return make_node<BoundType>(type->location(), type_maybe.value());
 }
 
 NODE_PROCESSOR(TypeDef)
@@ -301,7 +302,7 @@ NODE_PROCESSOR(TypeDef)
     // FIXME: Make sure type alias isn't yet used for type or function or var or ...
     auto bound_type = TRY_AND_CAST(BoundType, type_def->type(), ctx);
     bound_type->type()->has_alias(type_def->name());
-    return std::make_shared<BoundTypeDef>(type_def->location(), type_def->name(), bound_type);
+    return make_node<BoundTypeDef>(type_def->location(), type_def->name(), bound_type);
 }
 
 NODE_PROCESSOR(Compilation)
@@ -312,7 +313,7 @@ NODE_PROCESSOR(Compilation)
     for (auto& imported : compilation->modules()) {
         modules.push_back(TRY_AND_CAST(BoundModule, imported, ctx));
     }
-    return std::make_shared<BoundCompilation>(modules, ctx.custom_types(), compilation->main_module());
+    return make_node<BoundCompilation>(modules, ctx.custom_types(), compilation->main_module());
 }
 
 NODE_PROCESSOR(BoundCompilation)
@@ -325,7 +326,19 @@ NODE_PROCESSOR(BoundCompilation)
     for (auto& imported : compilation->modules()) {
         modules.push_back(TRY_AND_CAST(BoundModule, imported, ctx));
     }
-    return std::make_shared<BoundCompilation>(modules, ctx.custom_types(), compilation->main_module());
+    return make_node<BoundCompilation>(modules, ctx.custom_types(), compilation->main_module());
+}
+
+// Function definitions record their own pending bindings. Other module level
+// statements are retried with the module.
+static void mark_module_unbound(Statements const& statements, BindContext& module_ctx)
+{
+    for (auto const& stmt : statements) {
+        if (stmt->node_type() != SyntaxNodeType::BoundFunctionDef && !stmt->is_fully_bound()) {
+            module_ctx.mark_unbound();
+            return;
+        }
+    }
 }
 
 NODE_PROCESSOR(Module)
@@ -338,8 +351,9 @@ NODE_PROCESSOR(Module)
     for (auto& stmt : module->statements()) {
         statements.push_back(TRY_AND_CAST(Statement, stmt, module_ctx));
     }
-    auto block = std::make_shared<Block>(tree->location(), statements);
-    auto ret = std::make_shared<BoundModule>(module->location(), module->name(), block, module_ctx.exports(), module_ctx.imports());
+    mark_module_unbound(statements, module_ctx);
+    auto block = make_node<Block>(tree->location(), statements);
+    auto ret = make_node<BoundModule>(module->location(), module->name(), block, module_ctx.exports(), module_ctx.imports());
     ctx.add_module(ret);
     return ret;
 }
@@ -347,7 +361,7 @@ NODE_PROCESSOR(Module)
 NODE_PROCESSOR(BoundModule)
 {
     auto module = std::dynamic_pointer_cast<BoundModule>(tree);
-    if (module->is_fully_bound())
+    if (module->is_fully_bound() || !ctx.must_rebind_module(module->name()))
         return tree;
     assert(ctx.type() == BindContextType::RootContext);
     auto& module_ctx = ctx.make_modulecontext(module->name());
@@ -355,8 +369,9 @@ NODE_PROCESSOR(BoundModule)
     for (auto& stmt : module->block()->statements()) {
         statements.push_back(TRY_AND_CAST(Statement, stmt, module_ctx));
     }
-    auto block = std::make_shared<Block>(tree->location(), statements);
-    return std::make_shared<BoundModule>(module->location(), module->name(), block, module_ctx.exports(), module_ctx.imports());
+    mark_module_unbound(statements, module_ctx);
+    auto block = make_node<Block>(tree->location(), statements);
+    return make_node<BoundModule>(module->location(), module->name(), block, module_ctx.exports(), module_ctx.imports());
 }
 
 NODE_PROCESSOR(BoundStructDefinition)
@@ -370,7 +385,7 @@ NODE_PROCESSOR(BoundStructDefinition)
     for (auto& method : struct_def->methods()) {
         methods.push_back(TRY_AND_CAST(Statement, method, struct_ctx));
     }
-    return std::make_shared<BoundStructDefinition>(struct_def->location(), struct_def->type(), struct_def->fields(), methods);
+    return make_node<BoundStructDefinition>(struct_def->location(), struct_def->type(), struct_def->fields(), methods);
 }
 
 NODE_PROCESSOR(VariableDeclaration)
@@ -393,24 +408,24 @@ NODE_PROCESSOR(VariableDeclaration)
 
     if (var_type->is_custom())
         ctx.add_custom_type(var_type);
-    auto identifier = std::make_shared<BoundIdentifier>(var_decl->identifier(), var_type);
+    auto identifier = make_node<BoundIdentifier>(var_decl->identifier(), var_type);
     std::shared_ptr<BoundVariableDeclaration> ret;
     bool is_exported { false };
     switch (tree->node_type()) {
     case SyntaxNodeType::VariableDeclaration:
-        ret = std::make_shared<BoundVariableDeclaration>(var_decl, identifier, expr);
+        ret = make_node<BoundVariableDeclaration>(var_decl, identifier, expr);
         break;
     case SyntaxNodeType::StaticVariableDeclaration:
-        ret = std::make_shared<BoundStaticVariableDeclaration>(var_decl, identifier, expr);
+        ret = make_node<BoundStaticVariableDeclaration>(var_decl, identifier, expr);
         break;
     case SyntaxNodeType::LocalVariableDeclaration:
-        ret = std::make_shared<BoundLocalVariableDeclaration>(var_decl, identifier, expr);
+        ret = make_node<BoundLocalVariableDeclaration>(var_decl, identifier, expr);
         // Even though this variable cannot be accessed from other modules, we declare
         // it anyway, so we can give an error message when an attempt is made to access it:
         is_exported = true;
         break;
     case SyntaxNodeType::GlobalVariableDeclaration:
-        ret = std::make_shared<BoundGlobalVariableDeclaration>(var_decl, identifier, expr);
+        ret = make_node<BoundGlobalVariableDeclaration>(var_decl, identifier, expr);
         is_exported = true;
         break;
     default:
@@ -449,26 +464,26 @@ NODE_PROCESSOR(FunctionDecl)
             ctx.add_custom_type(ret_type);
     }
 
-    auto identifier = std::make_shared<BoundIdentifier>(decl->identifier(), ret_type);
+    auto identifier = make_node<BoundIdentifier>(decl->identifier(), ret_type);
     BoundIdentifiers bound_parameters;
     for (auto& parameter : decl->parameters()) {
         if (parameter->type() == nullptr)
             return SyntaxError { parameter->location(), "Untyped function parameter '{}'", parameter->name() };
         auto parameter_type = TRY(parameter->type()->resolve_type());
-        bound_parameters.push_back(std::make_shared<BoundIdentifier>(parameter, parameter_type));
+        bound_parameters.push_back(make_node<BoundIdentifier>(parameter, parameter_type));
         if (parameter_type->is_custom() && decl->node_type() != SyntaxNodeType::IntrinsicDecl)
             ctx.add_custom_type(parameter_type);
     }
     std::shared_ptr<BoundFunctionDecl> bound_decl;
     switch (decl->node_type()) {
     case SyntaxNodeType::IntrinsicDecl:
-        bound_decl = std::make_shared<BoundIntrinsicDecl>(std::dynamic_pointer_cast<IntrinsicDecl>(decl), decl->module(), identifier, bound_parameters);
+        bound_decl = make_node<BoundIntrinsicDecl>(std::dynamic_pointer_cast<IntrinsicDecl>(decl), decl->module(), identifier, bound_parameters);
         break;
     case SyntaxNodeType::NativeFunctionDecl:
-        bound_decl = std::make_shared<BoundNativeFunctionDecl>(std::dynamic_pointer_cast<NativeFunctionDecl>(decl), decl->module(), identifier, bound_parameters);
+        bound_decl = make_node<BoundNativeFunctionDecl>(std::dynamic_pointer_cast<NativeFunctionDecl>(decl), decl->module(), identifier, bound_parameters);
         break;
     default:
-        bound_decl = std::make_shared<BoundFunctionDecl>(decl, decl->module(), identifier, bound_parameters);
+        bound_decl = make_node<BoundFunctionDecl>(decl, decl->module(), identifier, bound_parameters);
         break;
     }
     if (!ctx.in_struct_def())
@@ -488,13 +503,16 @@ NODE_PROCESSOR(FunctionDef)
     if (func_def->statement()) {
         auto& func_ctx = ctx.make_subcontext();
         for (auto& param : decl->parameters()) {
-            auto dummy_decl = std::make_shared<VariableDeclaration>(param->location(), std::make_shared<Identifier>(param->location(), param->name()));
-            TRY_RETURN(func_ctx.declare(param->name(), std::make_shared<BoundVariableDeclaration>(dummy_decl, param, nullptr)));
+            auto dummy_decl = make_node<VariableDeclaration>(param->location(), make_node<Identifier>(param->location(), param->name()));
+            TRY_RETURN(func_ctx.declare(param->name(), make_node<BoundVariableDeclaration>(dummy_decl, param, nullptr)));
         }
         func_ctx.return_type = decl->type();
+        func_ctx.function_scope = decl->to_string();
         func_block = TRY_AND_CAST(Statement, func_def->statement(), func_ctx);
+        if (!func_block->is_fully_bound())
+            func_ctx.mark_unbound();
     }
-    return std::make_shared<BoundFunctionDef>(func_def, decl, func_block);
+    return make_node<BoundFunctionDef>(func_def, decl, func_block);
 }
 
 NODE_PROCESSOR(BoundFunctionDef)
@@ -503,15 +521,21 @@ NODE_PROCESSOR(BoundFunctionDef)
     if (!func_def->statement() || func_def->statement()->is_fully_bound())
         return tree;
 
+    auto scope = func_def->declaration()->to_string();
+    if (!ctx.must_rebind_scope(scope))
+        return tree;
     std::shared_ptr<Statement> func_block { nullptr };
     auto& func_ctx = ctx.make_subcontext();
+    func_ctx.function_scope = scope;
     for (auto& param : func_def->declaration()->parameters()) {
-        auto dummy_decl = std::make_shared<VariableDeclaration>(param->location(), std::make_shared<Identifier>(param->location(), param->name()));
-        TRY_RETURN(func_ctx.declare(param->name(), std::make_shared<BoundVariableDeclaration>(dummy_decl, param, nullptr)));
+        auto dummy_decl = make_node<VariableDeclaration>(param->location(), make_node<Identifier>(param->location(), param->name()));
+        TRY_RETURN(func_ctx.declare(param->name(), make_node<BoundVariableDeclaration>(dummy_decl, param, nullptr)));
     }
     func_ctx.return_type = func_def->declaration()->type();
     func_block = TRY_AND_CAST(Statement, func_def->statement(), func_ctx);
-    return std::make_shared<BoundFunctionDef>(func_def->location(), func_def->declaration(), func_block);
+    if (!func_block->is_fully_bound())
+        func_ctx.mark_unbound();
+    return make_node<BoundFunctionDef>(func_def->location(), func_def->declaration(), func_block);
 }
 
 NODE_PROCESSOR(BinaryExpression)
@@ -575,11 +599,11 @@ NODE_PROCESSOR(BinaryExpression)
         case PrimitiveType::Struct: {
             auto struct_type = lhs->type();
             if (auto field = struct_type->field(member_var->name()); field.type->type() != PrimitiveType::Unknown) {
-                auto member_identifier = std::make_shared<BoundIdentifier>(rhs->location(), member_var->name(), field.type);
-                return std::make_shared<BoundMemberAccess>(lhs, member_identifier);
+                auto member_identifier = make_node<BoundIdentifier>(rhs->location(), member_var->name(), field.type);
+                return make_node<BoundMemberAccess>(lhs, member_identifier);
             }
             if (struct_type->has_method(member_var->name()))
-                return std::make_shared<UnboundMemberAccess>(lhs, member_var);
+                return make_node<UnboundMemberAccess>(lhs, member_var);
             return SyntaxError { expr->location(), "Expression '{}' is not a member of struct '{}' of type '{}'", rhs, lhs, lhs->type() };
         }
         case PrimitiveType::Module: {
@@ -590,10 +614,10 @@ NODE_PROCESSOR(BinaryExpression)
                 auto var_decl = var_decl_maybe.value();
                 if (std::dynamic_pointer_cast<BoundGlobalVariableDeclaration>(var_decl) == nullptr)
                     return SyntaxError { expr->location(), "Variable '{}' is local to module '{}' and cannot be accessed from the current module", var_decl->name(), module->name() };
-                auto member_variable = std::make_shared<BoundVariable>(rhs->location(), member_var->name(), var_decl_maybe.value()->type());
-                return std::make_shared<BoundMemberAccess>(lhs, member_variable);
+                auto member_variable = make_node<BoundVariable>(rhs->location(), member_var->name(), var_decl_maybe.value()->type());
+                return make_node<BoundMemberAccess>(lhs, member_variable);
             }
-            return std::make_shared<UnboundMemberAccess>(lhs, member_var);
+            return make_node<UnboundMemberAccess>(lhs, member_var);
         }
         case PrimitiveType::Conditional: {
             if (member_var == nullptr || (member_var->name() != "value" && member_var->name() != "error"))
@@ -601,8 +625,8 @@ NODE_PROCESSOR(BinaryExpression)
             auto type = (member_var->name() == "value")
                 ? lhs->type()->template_argument<std::shared_ptr<ObjectType>>("success_type")
                 : lhs->type()->template_argument<std::shared_ptr<ObjectType>>("error_type");
-            auto member_identifier = std::make_shared<BoundIdentifier>(rhs->location(), member_var->name(), type);
-            return std::make_shared<BoundMemberAccess>(lhs, member_identifier);
+            auto member_identifier = make_node<BoundIdentifier>(rhs->location(), member_var->name(), type);
+            return make_node<BoundMemberAccess>(lhs, member_identifier);
         }
         case PrimitiveType::Type: {
             auto type_literal = std::dynamic_pointer_cast<BoundTypeLiteral>(lhs);
@@ -612,14 +636,14 @@ NODE_PROCESSOR(BinaryExpression)
             auto values = type_literal->value()->template_argument_values<NVP>("values");
             for (auto const& v : values) {
                 if (v.first == member_var->name())
-                    return std::make_shared<BoundEnumValue>(lhs->location(), type_literal->value(), v.first, v.second);
+                    return make_node<BoundEnumValue>(lhs->location(), type_literal->value(), v.first, v.second);
             }
             return SyntaxError { expr->location(), "Expression '{}' is not a member of enum '{}' of type '{}'", rhs, lhs, type_literal->value() };
         }
         default:
             if (member_var == nullptr)
                 return SyntaxError { expr->location(), "Expression '{}' is not a member of '{}'", rhs, lhs };
-            return std::make_shared<UnboundMemberAccess>(lhs, member_var);
+            return make_node<UnboundMemberAccess>(lhs, member_var);
         }
     }
 
@@ -656,7 +680,7 @@ NODE_PROCESSOR(BinaryExpression)
             if ((value < 0) || (lhs->type()->template_argument<long>("size") <= value))
                 return SyntaxError { rhs->location(), ErrorCode::IndexOutOfBounds, value, lhs->type()->template_argument<long>("size") };
         }
-        return std::make_shared<BoundArrayAccess>(lhs, rhs_bound, lhs->type()->template_argument<std::shared_ptr<ObjectType>>("base_type"));
+        return make_node<BoundArrayAccess>(lhs, rhs_bound, lhs->type()->template_argument<std::shared_ptr<ObjectType>>("base_type"));
     }
 
     if (op == BinaryOperator::Assign || BinaryOperator_is_assignment(op)) {
@@ -677,18 +701,18 @@ NODE_PROCESSOR(BinaryExpression)
 
         if (auto lhs_as_memberaccess = std::dynamic_pointer_cast<BoundMemberAccess>(assignee);
             lhs_as_memberaccess != nullptr && lhs_as_memberaccess->node_type() != SyntaxNodeType::BoundMemberAssignment) {
-            assignee = std::make_shared<BoundMemberAssignment>(lhs_as_memberaccess->structure(), lhs_as_memberaccess->member());
+            assignee = make_node<BoundMemberAssignment>(lhs_as_memberaccess->structure(), lhs_as_memberaccess->member());
         }
 
         rhs_bound = TRY(make_expression_for_assignment(rhs_bound, assignee->type()));
 
         if (op == BinaryOperator::Assign)
-            return std::make_shared<BoundAssignment>(expr->location(), assignee, rhs_bound);
+            return make_node<BoundAssignment>(expr->location(), assignee, rhs_bound);
 
         // +=, -= and friends: rewrite to a straight-up assignment to a binary
-        auto new_rhs = std::make_shared<BoundBinaryExpression>(expr->location(),
+        auto new_rhs = make_node<BoundBinaryExpression>(expr->location(),
             lhs, BinaryOperator_for_assignment_operator(op), rhs_bound, rhs_bound->type());
-        return std::make_shared<BoundAssignment>(expr->location(), assignee, new_rhs);
+        return make_node<BoundAssignment>(expr->location(), assignee, new_rhs);
     }
 
     if ((rhs_bound->node_type() == SyntaxNodeType::BoundIntLiteral) && (rhs_bound->type()->type() == lhs->type()->type()) && (rhs_bound->type()->size() > lhs->type()->size())) {
@@ -700,7 +724,7 @@ NODE_PROCESSOR(BinaryExpression)
     if (return_type != nullptr) {
         if (return_type->is_custom())
             ctx.add_custom_type(return_type);
-        return std::make_shared<BoundBinaryExpression>(expr, lhs, op, rhs_bound, return_type);
+        return make_node<BoundBinaryExpression>(expr, lhs, op, rhs_bound, return_type);
     }
     return SyntaxError { expr->location(), ErrorCode::ReturnTypeUnresolved, format("{} {} {}", lhs, op, rhs) };
 }
@@ -743,9 +767,9 @@ NODE_PROCESSOR(UnaryExpression)
                 auto field = struct_type->field(op_identifier->name());
                 if (field.type->type() == PrimitiveType::Unknown)
                     return SyntaxError { expr->location(), "Struct of type '{}' has no field '{}'", struct_type->name(), op_identifier->name() };
-                return std::make_shared<BoundMemberAccess>(
-                    std::make_shared<BoundVariable>(expr->location(), "$this", struct_type),
-                    std::make_shared<BoundIdentifier>(op_identifier, field.type));
+                return make_node<BoundMemberAccess>(
+                    make_node<BoundVariable>(expr->location(), "$this", struct_type),
+                    make_node<BoundIdentifier>(op_identifier, field.type));
             } else {
                 return SyntaxError { expr->location(), "Can only dereference struct fields using '.' in method definitions" };
             }
@@ -763,7 +787,7 @@ NODE_PROCESSOR(UnaryExpression)
         return SyntaxError { expr->location(), ErrorCode::ReturnTypeUnresolved, format("{} {}", op, operand) };
     if (return_type->is_custom())
         ctx.add_custom_type(return_type);
-    return std::make_shared<BoundUnaryExpression>(expr, operand, op, return_type);
+    return make_node<BoundUnaryExpression>(expr, operand, op, return_type);
 }
 
 NODE_PROCESSOR(CastExpression)
@@ -773,7 +797,7 @@ NODE_PROCESSOR(CastExpression)
     auto type = TRY(cast->type()->resolve_type());
     if (expr->type()->can_cast_to(type) == CanCast::Never)
         return SyntaxError { cast->location(), "Cannot cast {} to {}", expr->type(), type };
-    return std::make_shared<BoundCastExpression>(cast->location(), expr, type);
+    return make_node<BoundCastExpression>(cast->location(), expr, type);
 }
 
 NODE_PROCESSOR(ExpressionList)
@@ -784,18 +808,18 @@ NODE_PROCESSOR(ExpressionList)
         auto bound_expr = TRY_AND_TRY_CAST_RETURN(BoundExpression, expr, ctx, tree);
         bound_expressions.push_back(bound_expr);
     }
-    return std::make_shared<BoundExpressionList>(tree->location(), bound_expressions);
+    return make_node<BoundExpressionList>(tree->location(), bound_expressions);
 }
 
 NODE_PROCESSOR(Pass)
 {
     auto stmt = std::dynamic_pointer_cast<Pass>(tree);
-    return std::make_shared<BoundPass>(stmt->location(), stmt->elided_statement());
+    return make_node<BoundPass>(stmt->location(), stmt->elided_statement());
 }
 
 NODE_PROCESSOR(Import)
 {
-    return std::make_shared<BoundPass>(tree->location(), std::dynamic_pointer_cast<Import>(tree));
+    return make_node<BoundPass>(tree->location(), std::dynamic_pointer_cast<Import>(tree));
 }
 
 NODE_PROCESSOR(Variable)
@@ -804,12 +828,12 @@ NODE_PROCESSOR(Variable)
     auto declaration_maybe = ctx.get(variable->name());
     if (!declaration_maybe.has_value()) {
         if (auto type = ObjectType::get(variable->name()); (type != nullptr) && type->type() != PrimitiveType::Unknown)
-            return std::make_shared<BoundTypeLiteral>(variable->location(), type);
+            return make_node<BoundTypeLiteral>(variable->location(), type);
         if (auto module = ctx.module(variable->name()); module != nullptr)
             return module;
     } else {
         auto declaration = declaration_maybe.value();
-        return std::make_shared<BoundVariable>(variable, declaration->type());
+        return make_node<BoundVariable>(variable, declaration->type());
     }
     return tree;
 }
@@ -819,8 +843,8 @@ NODE_PROCESSOR(UnboundMemberAccess)
     auto member_access = std::dynamic_pointer_cast<UnboundMemberAccess>(tree);
     if (auto module = std::dynamic_pointer_cast<BoundModule>(member_access->structure()); module != nullptr) {
         if (auto var_decl_maybe = ctx.exported_variable(module->name(), member_access->member()->name()); var_decl_maybe.has_value()) {
-            auto member_variable = std::make_shared<BoundVariable>(member_access->member()->location(), member_access->member()->name(), var_decl_maybe.value()->type());
-            return std::make_shared<BoundMemberAccess>(module, member_variable);
+            auto member_variable = make_node<BoundVariable>(member_access->member()->location(), member_access->member()->name(), var_decl_maybe.value()->type());
+            return make_node<BoundMemberAccess>(module, member_variable);
         }
     }
     ctx.add_unresolved(member_access);
@@ -843,17 +867,17 @@ NODE_PROCESSOR(IntLiteral)
             sz *= 2;
         type = ObjectType::get(format("s{}", sz));
     }
-    return std::make_shared<BoundIntLiteral>(std::dynamic_pointer_cast<IntLiteral>(tree), type);
+    return make_node<BoundIntLiteral>(std::dynamic_pointer_cast<IntLiteral>(tree), type);
 }
 
 NODE_PROCESSOR(StringLiteral)
 {
-    return std::make_shared<BoundStringLiteral>(std::dynamic_pointer_cast<StringLiteral>(tree));
+    return make_node<BoundStringLiteral>(std::dynamic_pointer_cast<StringLiteral>(tree));
 }
 
 NODE_PROCESSOR(BooleanLiteral)
 {
-    return std::make_shared<BoundBooleanLiteral>(std::dynamic_pointer_cast<BooleanLiteral>(tree));
+    return make_node<BoundBooleanLiteral>(std::dynamic_pointer_cast<BooleanLiteral>(tree));
 }
 
 NODE_PROCESSOR(ExpressionStatement)
@@ -865,17 +889,17 @@ NODE_PROCESSOR(ExpressionStatement)
             result.warn(SyntaxError { expr->location(), "Discarding return value of function '{}'", func_call->name() });
             switch (expr->node_type()) {
             case SyntaxNodeType::BoundFunctionCall: {
-                expr = std::make_shared<BoundFunctionCall>(func_call, ObjectType::get(PrimitiveType::Void));
+                expr = make_node<BoundFunctionCall>(func_call, ObjectType::get(PrimitiveType::Void));
                 break;
             }
             case SyntaxNodeType::BoundNativeFunctionCall: {
                 auto native_call = std::dynamic_pointer_cast<BoundNativeFunctionCall>(expr);
-                expr = std::make_shared<BoundNativeFunctionCall>(native_call, ObjectType::get(PrimitiveType::Void));
+                expr = make_node<BoundNativeFunctionCall>(native_call, ObjectType::get(PrimitiveType::Void));
                 break;
             }
             case SyntaxNodeType::BoundIntrinsicCall: {
                 auto intrinsic_call = std::dynamic_pointer_cast<BoundIntrinsicCall>(expr);
-                expr = std::make_shared<BoundIntrinsicCall>(intrinsic_call, ObjectType::get(PrimitiveType::Void));
+                expr = make_node<BoundIntrinsicCall>(intrinsic_call, ObjectType::get(PrimitiveType::Void));
                 break;
             }
             default:
@@ -883,7 +907,7 @@ NODE_PROCESSOR(ExpressionStatement)
             }
         }
     }
-    return std::make_shared<BoundExpressionStatement>(expr_stmt, expr);
+    return make_node<BoundExpressionStatement>(expr_stmt, expr);
 }
 
 NODE_PROCESSOR(Return)
@@ -892,11 +916,11 @@ NODE_PROCESSOR(Return)
     if (ctx.return_type) {
         auto bound_expr = TRY_AND_TRY_CAST_RETURN(BoundExpression, ret_stmt->expression(), ctx, tree);
         bound_expr = TRY(make_expression_for_assignment(bound_expr, ctx.return_type));
-        return std::make_shared<BoundReturn>(ret_stmt, bound_expr, ret_stmt->return_error());
+        return make_node<BoundReturn>(ret_stmt, bound_expr, ret_stmt->return_error());
     } else {
         if (ret_stmt->expression())
             return SyntaxError { ret_stmt->location(), "Expected void return, got return value '{}'", ret_stmt->expression() };
-        return std::make_shared<BoundReturn>(ret_stmt, nullptr, ret_stmt->return_error());
+        return make_node<BoundReturn>(ret_stmt, nullptr, ret_stmt->return_error());
     }
 }
 
@@ -907,7 +931,7 @@ NODE_PROCESSOR(IfStatement)
     pStatement bound_else_stmt = nullptr;
     if (if_stmt->else_stmt() != nullptr)
         bound_else_stmt = TRY_AND_TRY_CAST_RETURN(Statement, if_stmt->else_stmt(), ctx, tree);
-    return std::make_shared<BoundIfStatement>(if_stmt, bound_branches, bound_else_stmt);
+    return make_node<BoundIfStatement>(if_stmt, bound_branches, bound_else_stmt);
 }
 
 NODE_PROCESSOR(WhileStatement)
@@ -917,7 +941,7 @@ NODE_PROCESSOR(WhileStatement)
     auto bound_statement = TRY_AND_CAST(Statement, stmt->statement(), ctx);
     if (!bound_statement->is_fully_bound())
         return tree;
-    return std::make_shared<BoundWhileStatement>(stmt, bound_condition, bound_statement);
+    return make_node<BoundWhileStatement>(stmt, bound_condition, bound_statement);
 }
 
 NODE_PROCESSOR(ForStatement)
@@ -952,7 +976,7 @@ NODE_PROCESSOR(ForStatement)
         auto int_literal = std::dynamic_pointer_cast<BoundIntLiteral>(range_binary_expr->lhs());
         if (int_literal != nullptr) {
             auto casted = TRY(int_literal->cast(var_type));
-            range_binary_expr = std::make_shared<BoundBinaryExpression>(range_binary_expr->location(), casted,
+            range_binary_expr = make_node<BoundBinaryExpression>(range_binary_expr->location(), casted,
                 range_binary_expr->op(), range_binary_expr->rhs(), range_binary_expr->type());
         } else {
             return SyntaxError { stmt->location(), ErrorCode::TypeMismatch, stmt->variable()->name(), var_type, range_type };
@@ -963,16 +987,16 @@ NODE_PROCESSOR(ForStatement)
     }
 
     BindContext for_ctx(ctx);
-    auto bound_var_decl = std::make_shared<BoundVariableDeclaration>(stmt->location(),
-        std::make_shared<BoundIdentifier>(stmt->location(), stmt->variable()->name(), var_type),
+    auto bound_var_decl = make_node<BoundVariableDeclaration>(stmt->location(),
+        make_node<BoundIdentifier>(stmt->location(), stmt->variable()->name(), var_type),
         false, nullptr);
-    auto bound_var = std::make_shared<BoundVariable>(stmt->variable(), var_type);
+    auto bound_var = make_node<BoundVariable>(stmt->variable(), var_type);
     if (must_declare_variable)
         TRY_RETURN(for_ctx.declare(stmt->variable()->name(), bound_var_decl));
     auto bound_statement = TRY_AND_CAST(Statement, stmt->statement(), for_ctx);
     if (!bound_statement->is_fully_bound())
         return tree;
-    return std::make_shared<BoundForStatement>(stmt, bound_var, range_binary_expr, bound_statement, must_declare_variable);
+    return make_node<BoundForStatement>(stmt, bound_var, range_binary_expr, bound_statement, must_declare_variable);
 }
 
 NODE_PROCESSOR(CaseStatement)
@@ -982,7 +1006,7 @@ NODE_PROCESSOR(CaseStatement)
     auto bound_statement = TRY_AND_CAST(Statement, branch->statement(), ctx);
     if (!bound_statement->is_fully_bound())
         return tree;
-    return std::make_shared<BoundBranch>(branch, bound_condition, bound_statement);
+    return make_node<BoundBranch>(branch, bound_condition, bound_statement);
 }
 
 NODE_PROCESSOR(DefaultCase)
@@ -991,7 +1015,7 @@ NODE_PROCESSOR(DefaultCase)
     auto bound_statement = TRY_AND_CAST(Statement, branch->statement(), ctx);
     if (!bound_statement->is_fully_bound())
         return tree;
-    return std::make_shared<BoundBranch>(branch, nullptr, bound_statement);
+    return make_node<BoundBranch>(branch, nullptr, bound_statement);
 }
 
 NODE_PROCESSOR(SwitchStatement)
@@ -1000,20 +1024,26 @@ NODE_PROCESSOR(SwitchStatement)
     auto bound_expression = TRY_AND_TRY_CAST_RETURN(BoundExpression, stmt->expression(), ctx, tree);
     BoundBranches bound_branches = PROCESS_BRANCHES(tree, stmt->cases(), ctx);
     auto bound_default_case = PROCESS_BRANCH(tree, stmt->default_case(), ctx);
-    return std::make_shared<BoundSwitchStatement>(stmt->location(), bound_expression, bound_branches, bound_default_case);
+    return make_node<BoundSwitchStatement>(stmt->location(), bound_expression, bound_branches, bound_default_case);
 }
 
 ProcessResult& bind_types(Config const& config, ProcessResult& result)
 {
     BindContext root;
-    auto new_unbound = std::numeric_limits<int>().max();
-    int unbound;
+    auto unbound = std::numeric_limits<int>().max();
+    int new_unbound;
     root.stage = 1;
     pSyntaxNode t = result.value();
     std::cout << "Type checking...\n";
-    do {
-        unbound = new_unbound;
-        root.clear_unresolved();
+
+    // The first pass visits everything. After that only the scopes waiting for
+    // a name that was declared in the previous pass are rebound. If such a
+    // targeted pass doesn't make progress, one more full pass is done before
+    // giving up.
+    auto full_pass = true;
+    while (true) {
+        Stopwatch stopwatch;
+        root.start_pass(full_pass);
         process(t, root, result);
         if (result.is_error())
             return result;
@@ -1022,10 +1052,21 @@ ProcessResult& bind_types(Config const& config, ProcessResult& result)
         auto compilation = std::dynamic_pointer_cast<BoundCompilation>(t);
         assert(compilation != nullptr);
         new_unbound = compilation->unbound_statements();
+        CompilerStats::get_stats().add_phase(format("bind pass {}", root.stage), stopwatch, t);
         std::cout << "Pass " << root.stage++ << ": " << new_unbound << " unbound statements" << '\n';
         if (config.cmdline_flag<bool>("dump-functions"))
             root.dump();
-    } while (new_unbound > 0 && new_unbound < unbound);
+        if (new_unbound == 0)
+            break;
+        if (new_unbound < unbound) {
+            unbound = new_unbound;
+            full_pass = false;
+            continue;
+        }
+        if (full_pass)
+            break;
+        full_pass = true;
+    }
     std::cout << "\n";
 
     if (new_unbound > 0) {
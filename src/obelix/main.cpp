@@ -5,8 +5,10 @@
  */
 
 #include <cstdio>
+#include <fstream>
 #include <optional>
 
+#include <obelix/Stats.h>
 #include <obelix/parser/Parser.h>
 
 void usage()
@@ -27,6 +29,16 @@ int main(int argc, char const** argv)
         exit(-1);
     }
 
+    // Declared before the result, so that it outlives the syntax tree:
+    std::optional<Obelix::NodeArena> arena;
+    if (config.cmdline_flag<bool>("arena"))
+        arena.emplace();
+
+    auto& stats = Obelix::CompilerStats::get_stats();
+    auto stats_json = config.cmdline_flag<std::string>("stats-json");
+    if (config.cmdline_flag<bool>("stats") || !stats_json.empty())
+        stats.enable();
+
     auto result = Obelix::compile_project(config);
     for (auto const& e : result.errors()) {
         std::cerr << "ERROR: " << e.location().to_string() << " " << e.message() << "\n";
@@ -34,5 +46,14 @@ int main(int argc, char const** argv)
     for (auto const& e : result.warnings()) {
         std::cerr << "WARNING: " << e.location().to_string() << " " << e.message() << "\n";
     }
+    if (config.cmdline_flag<bool>("stats"))
+        stats.report(std::cerr);
+    if (!stats_json.empty()) {
+        std::ofstream json(stats_json);
+        if (json.is_open())
+            stats.write_json(json);
+        else
+            std::cerr << "ERROR: Could not write statistics to '" << stats_json << "'\n";
+    }
     return (result.is_error()) ? -1 : 0;
 }
@@ -0,0 +1,820 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifdef __APPLE__
+#    include <mach-o/dyld.h>
+#endif
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include <config.h>
+#include <obelix/Cache.h>
+#include <obelix/Hash.h>
+#include <obelix/Syntax.h>
+#include <obelix/parser/ModuleCache.h>
+
+namespace Obelix {
+
+extern_logging_category(parser);
+
+namespace fs = std::filesystem;
+
+// Must change whenever the layout written by ModuleWriter changes:
+constexpr static uint64_t ModuleCacheVersion = 1;
+constexpr static char const* ModuleCacheMagic = "obelix parse tree";
+
+// Least recently used parse trees are evicted beyond this many entries.
+constexpr static size_t MaxCachedModules = 1024;
+
+// Written in place of the node type of an absent child node.
+constexpr static uint64_t NullNode = static_cast<uint64_t>(SyntaxNodeType::Count);
+
+static fs::path running_executable()
+{
+#ifdef __APPLE__
+    uint32_t size = 0;
+    _NSGetExecutablePath(nullptr, &size);
+    std::string path(size, '\0');
+    if (_NSGetExecutablePath(path.data(), &size) != 0)
+        return {};
+    return fs::path(path.c_str());
+#else
+    std::error_code ec;
+    auto path = fs::read_symlink("/proc/self/exe", ec);
+    if (ec)
+        return {};
+    return path;
+#endif
+}
+
+// The size and modification time of the executable change with every build,
+// and are much cheaper to get than a hash of it.
+std::optional<std::string> compiler_build_identity()
+{
+    static std::optional<std::string> identity = []() -> std::optional<std::string> {
+        auto executable = running_executable();
+        if (executable.empty())
+            return {};
+        auto stamp = file_stamp(executable);
+        if (!stamp.has_value())
+            return {};
+        return format("{} {}", OBELIX_VERSION, stamp.value());
+    }();
+    return identity;
+}
+
+static fs::path cache_directory()
+{
+    return fs::path(".obelix") / "parse";
+}
+
+static fs::path cache_file(std::string const& module_name, std::string const& path)
+{
+    return cache_directory() / (ContentHash().add(module_name).add(path).to_string() + ".ast");
+}
+
+// Writes syntax nodes as their node type followed by the arguments needed to
+// construct them again. Integers are written as LEB128, strings as their
+// length followed by their bytes. The file names of spans are written once,
+// and referred to by index after that.
+class ModuleWriter {
+public:
+    [[nodiscard]] std::string const& data() const { return m_data; }
+
+    void write_uint(uint64_t value)
+    {
+        do {
+            auto byte = static_cast<uint8_t>(value & 0x7f);
+            value >>= 7;
+            if (value != 0)
+                byte |= 0x80;
+            m_data += static_cast<char>(byte);
+        } while (value != 0);
+    }
+
+    void write_int(int64_t value)
+    {
+        write_uint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void write_bool(bool value)
+    {
+        write_uint((value) ? 1 : 0);
+    }
+
+    void write_string(std::string_view const& value)
+    {
+        write_uint(value.length());
+        m_data += value;
+    }
+
+    void write_span(Span const& span)
+    {
+        if (auto it = m_file_names.find(span.file_name); it != m_file_names.end()) {
+            write_uint(it->second);
+        } else {
+            auto index = m_file_names.size();
+            m_file_names[span.file_name] = index;
+            write_uint(index);
+            write_string(span.file_name);
+        }
+        write_uint(span.start_line);
+        write_uint(span.start_column);
+        write_uint(span.end_line);
+        write_uint(span.end_column);
+    }
+
+    void write_token(Token const& token)
+    {
+        write_span(token.location());
+        write_uint(static_cast<uint64_t>(token.code()));
+        write_string(token.value());
+    }
+
+    template<class NodeClass>
+    bool write_nodes(std::vector<std::shared_ptr<NodeClass>> const& nodes)
+    {
+        write_uint(nodes.size());
+        for (auto const& node : nodes) {
+            if (!write_node(node))
+                return false;
+        }
+        return true;
+    }
+
+    // Returns false if the tree contains nodes the parser doesn't create.
+    bool write_node(pSyntaxNode const& node)
+    {
+        if (node == nullptr) {
+            write_uint(NullNode);
+            return true;
+        }
+        write_uint(static_cast<uint64_t>(node->node_type()));
+        switch (node->node_type()) {
+        case SyntaxNodeType::Module: {
+            auto module = std::dynamic_pointer_cast<Module>(node);
+            write_span(module->location());
+            write_string(module->name());
+            return write_nodes(module->statements());
+        }
+        case SyntaxNodeType::Block: {
+            auto block = std::dynamic_pointer_cast<Block>(node);
+            write_span(block->location());
+            return write_nodes(block->statements());
+        }
+        case SyntaxNodeType::Import: {
+            auto import = std::dynamic_pointer_cast<Import>(node);
+            write_span(import->location());
+            write_string(import->name());
+            return true;
+        }
+        case SyntaxNodeType::Pass: {
+            auto pass = std::dynamic_pointer_cast<Pass>(node);
+            write_span(pass->location());
+            return write_node(pass->elided_statement());
+        }
+        case SyntaxNodeType::Break:
+        case SyntaxNodeType::Continue:
+        case SyntaxNodeType::This:
+            write_span(node->location());
+            return true;
+        case SyntaxNodeType::ExpressionStatement:
+            return write_node(std::dynamic_pointer_cast<ExpressionStatement>(node)->expression());
+        case SyntaxNodeType::Return: {
+            auto return_stmt = std::dynamic_pointer_cast<Return>(node);
+            write_span(return_stmt->location());
+            write_bool(return_stmt->return_error());
+            return write_node(return_stmt->expression());
+        }
+        case SyntaxNodeType::VariableDeclaration:
+        case SyntaxNodeType::StaticVariableDeclaration:
+        case SyntaxNodeType::LocalVariableDeclaration:
+        case SyntaxNodeType::GlobalVariableDeclaration: {
+            auto var_decl = std::dynamic_pointer_cast<VariableDeclaration>(node);
+            write_span(var_decl->location());
+            write_bool(var_decl->is_const());
+            return write_node(var_decl->identifier()) && write_node(var_decl->expression());
+        }
+        case SyntaxNodeType::FunctionDecl:
+        case SyntaxNodeType::IntrinsicDecl: {
+            auto func_decl = std::dynamic_pointer_cast<FunctionDecl>(node);
+            write_span(func_decl->location());
+            write_string(func_decl->module());
+            return write_node(func_decl->identifier()) && write_nodes(func_decl->parameters());
+        }
+        case SyntaxNodeType::NativeFunctionDecl: {
+            auto func_decl = std::dynamic_pointer_cast<NativeFunctionDecl>(node);
+            write_span(func_decl->location());
+            write_string(func_decl->module());
+            write_string(func_decl->native_function_name());
+            return write_node(func_decl->identifier()) && write_nodes(func_decl->parameters());
+        }
+        case SyntaxNodeType::FunctionDef: {
+            auto func_def = std::dynamic_pointer_cast<FunctionDef>(node);
+            write_span(func_def->location());
+            return write_node(func_def->declaration()) && write_node(func_def->statement());
+        }
+        case SyntaxNodeType::StructForward: {
+            auto forward = std::dynamic_pointer_cast<StructForward>(node);
+            write_span(forward->location());
+            write_string(forward->name());
+            return true;
+        }
+        case SyntaxNodeType::StructDefinition: {
+            auto struct_def = std::dynamic_pointer_cast<StructDefinition>(node);
+            write_span(struct_def->location());
+            write_string(struct_def->name());
+            return write_nodes(struct_def->fields()) && write_nodes(struct_def->methods());
+        }
+        case SyntaxNodeType::EnumValue: {
+            auto enum_value = std::dynamic_pointer_cast<EnumValue>(node);
+            write_span(enum_value->location());
+            write_string(enum_value->label());
+            write_bool(enum_value->value().has_value());
+            write_int(enum_value->value().value_or(0));
+            return true;
+        }
+        case SyntaxNodeType::EnumDef: {
+            auto enum_def = std::dynamic_pointer_cast<EnumDef>(node);
+            write_span(enum_def->location());
+            write_string(enum_def->name());
+            write_bool(enum_def->extend());
+            return write_nodes(enum_def->values());
+        }
+        case SyntaxNodeType::TypeDef: {
+            auto type_def = std::dynamic_pointer_cast<TypeDef>(node);
+            write_span(type_def->location());
+            write_string(type_def->name());
+            return write_node(type_def->type());
+        }
+        case SyntaxNodeType::Branch:
+        case SyntaxNodeType::CaseStatement:
+        case SyntaxNodeType::DefaultCase: {
+            auto branch = std::dynamic_pointer_cast<Branch>(node);
+            write_span(branch->location());
+            return write_node(branch->condition()) && write_node(branch->statement());
+        }
+        case SyntaxNodeType::IfStatement: {
+            auto if_stmt = std::dynamic_pointer_cast<IfStatement>(node);
+            write_span(if_stmt->location());
+            return write_nodes(if_stmt->branches()) && write_node(if_stmt->else_stmt());
+        }
+        case SyntaxNodeType::WhileStatement: {
+            auto while_stmt = std::dynamic_pointer_cast<WhileStatement>(node);
+            write_span(while_stmt->location());
+            return write_node(while_stmt->condition()) && write_node(while_stmt->statement());
+        }
+        case SyntaxNodeType::ForStatement: {
+            auto for_stmt = std::dynamic_pointer_cast<ForStatement>(node);
+            write_span(for_stmt->location());
+            return write_node(for_stmt->variable()) && write_node(for_stmt->range()) && write_node(for_stmt->statement());
+        }
+        case SyntaxNodeType::SwitchStatement: {
+            auto switch_stmt = std::dynamic_pointer_cast<SwitchStatement>(node);
+            write_span(switch_stmt->location());
+            return write_node(switch_stmt->expression()) && write_nodes(switch_stmt->cases()) && write_node(switch_stmt->default_case());
+        }
+        case SyntaxNodeType::ExpressionList: {
+            auto list = std::dynamic_pointer_cast<ExpressionList>(node);
+            write_span(list->location());
+            return write_nodes(list->expressions());
+        }
+        case SyntaxNodeType::Identifier:
+        case SyntaxNodeType::Variable: {
+            auto identifier = std::dynamic_pointer_cast<Identifier>(node);
+            write_span(identifier->location());
+            write_string(identifier->name());
+            return write_node(identifier->type());
+        }
+        case SyntaxNodeType::BinaryExpression: {
+            auto expr = std::dynamic_pointer_cast<BinaryExpression>(node);
+            write_token(expr->op());
+            return write_node(expr->lhs()) && write_node(expr->rhs()) && write_node(expr->type());
+        }
+        case SyntaxNodeType::UnaryExpression: {
+            auto expr = std::dynamic_pointer_cast<UnaryExpression>(node);
+            write_token(expr->op());
+            return write_node(expr->operand()) && write_node(expr->type());
+        }
+        case SyntaxNodeType::CastExpression: {
+            auto expr = std::dynamic_pointer_cast<CastExpression>(node);
+            write_span(expr->location());
+            return write_node(expr->expression()) && write_node(expr->type());
+        }
+        case SyntaxNodeType::IntLiteral:
+        case SyntaxNodeType::CharLiteral:
+        case SyntaxNodeType::FloatLiteral:
+        case SyntaxNodeType::StringLiteral:
+        case SyntaxNodeType::BooleanLiteral: {
+            auto literal = std::dynamic_pointer_cast<Literal>(node);
+            write_token(literal->token());
+            return write_node(literal->type());
+        }
+        case SyntaxNodeType::ExpressionType: {
+            auto type = std::dynamic_pointer_cast<ExpressionType>(node);
+            write_span(type->location());
+            write_string(type->type_name());
+            return write_nodes(type->template_arguments());
+        }
+        case SyntaxNodeType::StringTemplateArgument: {
+            auto arg = std::dynamic_pointer_cast<StringTemplateArgument>(node);
+            write_span(arg->location());
+            write_string(arg->value());
+            return true;
+        }
+        case SyntaxNodeType::IntegerTemplateArgument: {
+            auto arg = std::dynamic_pointer_cast<IntegerTemplateArgument>(node);
+            write_span(arg->location());
+            write_int(arg->value());
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+private:
+    std::string m_data;
+    std::unordered_map<std::string, uint64_t> m_file_names;
+};
+
+// Reads what ModuleWriter wrote. Malformed data doesn't abort; it marks the
+// reader as failed, and the module is parsed from source instead.
+class ModuleReader {
+public:
+    explicit ModuleReader(std::string_view data)
+        : m_data(data)
+    {
+    }
+
+    [[nodiscard]] bool failed() const { return m_failed; }
+    [[nodiscard]] bool at_end() const { return m_pos == m_data.length(); }
+    [[nodiscard]] Strings const& imports() const { return m_imports; }
+
+    uint64_t read_uint()
+    {
+        uint64_t ret = 0;
+        for (auto shift = 0; shift < 64; shift += 7) {
+            if (m_pos >= m_data.length()) {
+                m_failed = true;
+                return 0;
+            }
+            auto byte = static_cast<uint8_t>(m_data[m_pos++]);
+            ret |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return ret;
+        }
+        m_failed = true;
+        return 0;
+    }
+
+    int64_t read_int()
+    {
+        auto value = read_uint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    bool read_bool()
+    {
+        return read_uint() != 0;
+    }
+
+    std::string read_string()
+    {
+        auto length = read_uint();
+        if (m_failed || length > m_data.length() - m_pos) {
+            m_failed = true;
+            return "";
+        }
+        std::string ret { m_data.substr(m_pos, length) };
+        m_pos += length;
+        return ret;
+    }
+
+    Span read_span()
+    {
+        Span ret;
+        auto index = read_uint();
+        if (index == m_file_names.size())
+            m_file_names.push_back(read_string());
+        if (index >= m_file_names.size()) {
+            m_failed = true;
+            return ret;
+        }
+        ret.file_name = m_file_names[index];
+        ret.start_line = read_uint();
+        ret.start_column = read_uint();
+        ret.end_line = read_uint();
+        ret.end_column = read_uint();
+        return ret;
+    }
+
+    Token read_token()
+    {
+        auto location = read_span();
+        auto code = static_cast<TokenCode>(read_uint());
+        auto value = read_string();
+        return Token { std::move(location), code, std::move(value) };
+    }
+
+    // Reads a node that must be of the given class, or absent.
+    template<class NodeClass>
+    std::shared_ptr<NodeClass> read()
+    {
+        auto node = read_node();
+        if (node == nullptr)
+            return nullptr;
+        auto ret = std::dynamic_pointer_cast<NodeClass>(node);
+        if (ret == nullptr)
+            m_failed = true;
+        return ret;
+    }
+
+    template<class NodeClass>
+    std::vector<std::shared_ptr<NodeClass>> read_nodes()
+    {
+        std::vector<std::shared_ptr<NodeClass>> ret;
+        auto count = read_uint();
+        for (auto ix = 0u; ix < count && !m_failed; ++ix) {
+            auto node = read<NodeClass>();
+            if (node == nullptr) {
+                m_failed = true;
+                break;
+            }
+            ret.push_back(node);
+        }
+        return ret;
+    }
+
+    // Arguments are read into locals first, because the order in which the
+    // arguments of a call are evaluated is unspecified.
+    pSyntaxNode read_node()
+    {
+        auto node_type = read_uint();
+        if (m_failed || node_type == NullNode)
+            return nullptr;
+        if (node_type > NullNode) {
+            m_failed = true;
+            return nullptr;
+        }
+        switch (static_cast<SyntaxNodeType>(node_type)) {
+        case SyntaxNodeType::Module: {
+            auto location = read_span();
+            auto name = read_string();
+            auto statements = read_nodes<Statement>();
+            return finish(make_node<Module>(location, statements, name));
+        }
+        case SyntaxNodeType::Block: {
+            auto location = read_span();
+            auto statements = read_nodes<Statement>();
+            return finish(make_node<Block>(location, statements));
+        }
+        case SyntaxNodeType::Import: {
+            auto location = read_span();
+            auto name = read_string();
+            m_imports.push_back(name);
+            return finish(make_node<Import>(location, name));
+        }
+        case SyntaxNodeType::Pass: {
+            auto location = read_span();
+            auto elided_statement = read<Statement>();
+            if (elided_statement != nullptr)
+                return finish(make_node<Pass>(elided_statement));
+            return finish(make_node<Pass>(location));
+        }
+        case SyntaxNodeType::Break:
+            return finish(make_node<Break>(read_span()));
+        case SyntaxNodeType::Continue:
+            return finish(make_node<Continue>(read_span()));
+        case SyntaxNodeType::This:
+            return finish(make_node<This>(read_span()));
+        case SyntaxNodeType::ExpressionStatement: {
+            auto expression = read<Expression>();
+            if (expression == nullptr)
+                return fail();
+            return finish(make_node<ExpressionStatement>(expression));
+        }
+        case SyntaxNodeType::Return: {
+            auto location = read_span();
+            auto return_error = read_bool();
+            auto expression = read<Expression>();
+            return finish(make_node<Return>(location, expression, return_error));
+        }
+        case SyntaxNodeType::VariableDeclaration:
+            return read_variable_declaration<VariableDeclaration>();
+        case SyntaxNodeType::StaticVariableDeclaration:
+            return read_variable_declaration<StaticVariableDeclaration>();
+        case SyntaxNodeType::LocalVariableDeclaration:
+            return read_variable_declaration<LocalVariableDeclaration>();
+        case SyntaxNodeType::GlobalVariableDeclaration:
+            return read_variable_declaration<GlobalVariableDeclaration>();
+        case SyntaxNodeType::FunctionDecl:
+            return read_function_declaration<FunctionDecl>();
+        case SyntaxNodeType::IntrinsicDecl:
+            return read_function_declaration<IntrinsicDecl>();
+        case SyntaxNodeType::NativeFunctionDecl: {
+            auto location = read_span();
+            auto module = read_string();
+            auto native_function_name = read_string();
+            auto identifier = read<Identifier>();
+            auto parameters = read_nodes<Identifier>();
+            if (identifier == nullptr)
+                return fail();
+            return finish(make_node<NativeFunctionDecl>(location, module, identifier, parameters, native_function_name));
+        }
+        case SyntaxNodeType::FunctionDef: {
+            auto location = read_span();
+            auto declaration = read<FunctionDecl>();
+            auto statement = read<Statement>();
+            if (declaration == nullptr)
+                return fail();
+            return finish(make_node<FunctionDef>(location, declaration, statement));
+        }
+        case SyntaxNodeType::StructForward: {
+            auto location = read_span();
+            auto name = read_string();
+            return finish(make_node<StructForward>(location, name));
+        }
+        case SyntaxNodeType::StructDefinition: {
+            auto location = read_span();
+            auto name = read_string();
+            auto fields = read_nodes<Identifier>();
+            auto methods = read_nodes<FunctionDef>();
+            return finish(make_node<StructDefinition>(location, name, fields, methods));
+        }
+        case SyntaxNodeType::EnumValue: {
+            auto location = read_span();
+            auto label = read_string();
+            auto has_value = read_bool();
+            auto value = read_int();
+            return finish(make_node<EnumValue>(location, label, (has_value) ? std::optional<long> { value } : std::optional<long> {}));
+        }
+        case SyntaxNodeType::EnumDef: {
+            auto location = read_span();
+            auto name = read_string();
+            auto extend = read_bool();
+            auto values = read_nodes<EnumValue>();
+            return finish(make_node<EnumDef>(location, name, values, extend));
+        }
+        case SyntaxNodeType::TypeDef: {
+            auto location = read_span();
+            auto name = read_string();
+            auto type = read<ExpressionType>();
+            if (type == nullptr)
+                return fail();
+            return finish(make_node<TypeDef>(location, name, type));
+        }
+        case SyntaxNodeType::Branch:
+            return read_branch<Branch>();
+        case SyntaxNodeType::CaseStatement:
+            return read_branch<CaseStatement>();
+        case SyntaxNodeType::DefaultCase: {
+            auto location = read_span();
+            auto condition = read<Expression>();
+            auto statement = read<Statement>();
+            if (condition != nullptr || statement == nullptr)
+                return fail();
+            return finish(make_node<DefaultCase>(location, statement));
+        }
+        case SyntaxNodeType::IfStatement: {
+            auto location = read_span();
+            auto branches = read_nodes<Branch>();
+            auto else_stmt = read<Statement>();
+            if (branches.empty())
+                return fail();
+            // IfStatement turns a trailing branch without a condition into
+            // its else statement:
+            if (else_stmt != nullptr)
+                branches.push_back(make_node<Branch>(else_stmt->location(), else_stmt));
+            return finish(make_node<IfStatement>(location, branches));
+        }
+        case SyntaxNodeType::WhileStatement: {
+            auto location = read_span();
+            auto condition = read<Expression>();
+            auto statement = read<Statement>();
+            return finish(make_node<WhileStatement>(location, condition, statement));
+        }
+        case SyntaxNodeType::ForStatement: {
+            auto location = read_span();
+            auto variable = read<Variable>();
+            auto range = read<Expression>();
+            auto statement = read<Statement>();
+            return finish(make_node<ForStatement>(location, variable, range, statement));
+        }
+        case SyntaxNodeType::SwitchStatement: {
+            auto location = read_span();
+            auto expression = read<Expression>();
+            auto cases = read_nodes<CaseStatement>();
+            auto default_case = read<DefaultCase>();
+            return finish(make_node<SwitchStatement>(location, expression, cases, default_case));
+        }
+        case SyntaxNodeType::ExpressionList: {
+            auto location = read_span();
+            auto expressions = read_nodes<Expression>();
+            return finish(make_node<ExpressionList>(location, expressions));
+        }
+        case SyntaxNodeType::Identifier:
+            return read_identifier<Identifier>();
+        case SyntaxNodeType::Variable:
+            return read_identifier<Variable>();
+        case SyntaxNodeType::BinaryExpression: {
+            auto op = read_token();
+            auto lhs = read<Expression>();
+            auto rhs = read<Expression>();
+            auto type = read<ExpressionType>();
+            if (lhs == nullptr || rhs == nullptr)
+                return fail();
+            return finish(make_node<BinaryExpression>(lhs, op, rhs, type));
+        }
+        case SyntaxNodeType::UnaryExpression: {
+            auto op = read_token();
+            auto operand = read<Expression>();
+            auto type = read<ExpressionType>();
+            if (operand == nullptr)
+                return fail();
+            return finish(make_node<UnaryExpression>(op, operand, type));
+        }
+        case SyntaxNodeType::CastExpression: {
+            auto location = read_span();
+            auto expression = read<Expression>();
+            auto type = read<ExpressionType>();
+            return finish(make_node<CastExpression>(location, expression, type));
+        }
+        case SyntaxNodeType::IntLiteral:
+            return read_literal<IntLiteral>();
+        case SyntaxNodeType::CharLiteral:
+            return read_literal<CharLiteral>();
+        case SyntaxNodeType::FloatLiteral:
+            return read_literal<FloatLiteral>();
+        case SyntaxNodeType::StringLiteral:
+            return read_literal<StringLiteral>();
+        case SyntaxNodeType::BooleanLiteral:
+            return read_literal<BooleanLiteral>();
+        case SyntaxNodeType::ExpressionType: {
+            auto location = read_span();
+            auto type_name = read_string();
+            auto template_arguments = read_nodes<TemplateArgumentNode>();
+            return finish(make_node<ExpressionType>(location, type_name, template_arguments));
+        }
+        case SyntaxNodeType::StringTemplateArgument: {
+            auto location = read_span();
+            auto value = read_string();
+            return finish(make_node<StringTemplateArgument>(location, value));
+        }
+        case SyntaxNodeType::IntegerTemplateArgument: {
+            auto location = read_span();
+            auto value = read_int();
+            return finish(make_node<IntegerTemplateArgument>(location, value));
+        }
+        default:
+            return fail();
+        }
+    }
+
+private:
+    pSyntaxNode fail()
+    {
+        m_failed = true;
+        return nullptr;
+    }
+
+    // Nodes built from partially read data are dropped.
+    pSyntaxNode finish(pSyntaxNode const& node)
+    {
+        return (m_failed) ? nullptr : node;
+    }
+
+    template<class DeclClass>
+    pSyntaxNode read_variable_declaration()
+    {
+        auto location = read_span();
+        auto is_const = read_bool();
+        auto identifier = read<Identifier>();
+        auto expression = read<Expression>();
+        if (identifier == nullptr)
+            return fail();
+        return finish(make_node<DeclClass>(location, identifier, expression, is_const));
+    }
+
+    template<class DeclClass>
+    pSyntaxNode read_function_declaration()
+    {
+        auto location = read_span();
+        auto module = read_string();
+        auto identifier = read<Identifier>();
+        auto parameters = read_nodes<Identifier>();
+        if (identifier == nullptr)
+            return fail();
+        return finish(make_node<DeclClass>(location, module, identifier, parameters));
+    }
+
+    template<class BranchClass>
+    pSyntaxNode read_branch()
+    {
+        auto location = read_span();
+        auto condition = read<Expression>();
+        auto statement = read<Statement>();
+        if (statement == nullptr)
+            return fail();
+        return finish(make_node<BranchClass>(location, condition, statement));
+    }
+
+    template<class IdentifierClass>
+    pSyntaxNode read_identifier()
+    {
+        auto location = read_span();
+        auto name = read_string();
+        auto type = read<ExpressionType>();
+        return finish(make_node<IdentifierClass>(location, name, type));
+    }
+
+    template<class LiteralClass>
+    pSyntaxNode read_literal()
+    {
+        auto token = read_token();
+        auto type = read<ExpressionType>();
+        return finish(make_node<LiteralClass>(token, type));
+    }
+
+    std::string_view m_data;
+    size_t m_pos { 0 };
+    bool m_failed { false };
+    Strings m_file_names;
+    Strings m_imports;
+};
+
+std::shared_ptr<Module> load_cached_module(ParserContext& ctx, std::string const& module_name, std::string const& path, std::string const& source_hash)
+{
+    auto identity = compiler_build_identity();
+    if (!identity.has_value())
+        return nullptr;
+    auto file = cache_file(module_name, path);
+    std::ifstream s(file, std::ios::binary);
+    if (!s.is_open())
+        return nullptr;
+    std::string data { std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>() };
+
+    ModuleReader reader(data);
+    if (reader.read_string() != ModuleCacheMagic || reader.read_uint() != ModuleCacheVersion
+        || reader.read_string() != identity.value() || reader.read_string() != source_hash) {
+        debug(parser, "Cached parse tree of '{}' is out of date", module_name);
+        return nullptr;
+    }
+    auto module = reader.read<Module>();
+    if (reader.failed() || module == nullptr || !reader.at_end()) {
+        debug(parser, "Cached parse tree of '{}' is corrupt", module_name);
+        return nullptr;
+    }
+    for (auto const& import : reader.imports())
+        ctx.add_module(import);
+    touch_cache_entry(file);
+    return module;
+}
+
+void store_cached_module(std::shared_ptr<Module> const& module, std::string const& module_name, std::string const& path, std::string const& source_hash)
+{
+    auto identity = compiler_build_identity();
+    if (!identity.has_value())
+        return;
+    ModuleWriter writer;
+    writer.write_string(ModuleCacheMagic);
+    writer.write_uint(ModuleCacheVersion);
+    writer.write_string(identity.value());
+    writer.write_string(source_hash);
+    if (!writer.write_node(module)) {
+        debug(parser, "Parse tree of '{}' can't be cached", module_name);
+        return;
+    }
+
+    // Written to a temporary file that is renamed into place, so that a
+    // concurrent build never reads a partially written tree:
+    std::error_code ec;
+    fs::create_directories(cache_directory(), ec);
+    auto file = cache_file(module_name, path);
+    auto temp_file = file;
+    temp_file += format(".{}", std::to_string(getpid()));
+    {
+        std::ofstream s(temp_file, std::ios::binary);
+        s.write(writer.data().data(), static_cast<std::streamsize>(writer.data().length()));
+        if (s.fail()) {
+            s.close();
+            fs::remove(temp_file, ec);
+            return;
+        }
+    }
+    fs::rename(temp_file, file, ec);
+    if (ec)
+        fs::remove(temp_file, ec);
+}
+
+void trim_module_cache()
+{
+    trim_cache(cache_directory(), MaxCachedModules);
+}
+
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <obelix/parser/Parser.h>
+
+namespace Obelix {
+
+// Parse trees of modules are stored in .obelix/parse, one file per module,
+// together with a hash of the module's source text and the build of the
+// compiler that wrote them. When a project is rebuilt, only the modules
+// whose source changed are parsed again.
+
+// Identifies the build of the running compiler, or nothing if the running
+// executable can't be found.
+[[nodiscard]] std::optional<std::string> compiler_build_identity();
+
+// Returns the cached parse tree of the module in the given source file, or
+// nullptr if there is none or if it was made from different source text or
+// by a different compiler. Modules imported by a module loaded from the
+// cache are queued in the context, just like the parser does.
+[[nodiscard]] std::shared_ptr<Module> load_cached_module(ParserContext&, std::string const& module_name, std::string const& path, std::string const& source_hash);
+
+void store_cached_module(std::shared_ptr<Module> const&, std::string const& module_name, std::string const& path, std::string const& source_hash);
+
+// Evicts the least recently used parse trees once there are too many.
+void trim_module_cache();
+
+}
@@ -85,7 +85,7 @@ std::shared_ptr<Module> Parser::parse()
     parse_statements(statements, true);
     if (has_errors())
         return nullptr;
-    return std::make_shared<Module>(statements, m_current_module);
+    return make_node<Module>(statements, m_current_module);
 }
 
 std::shared_ptr<Statement> Parser::parse_top_level_statement()
@@ -95,7 +95,7 @@ std::shared_ptr<Statement> Parser::parse_top_level_statement()
     std::shared_ptr<Statement> ret;
     switch (token.code()) {
     case TokenCode::SemiColon:
-        return std::make_shared<Pass>(lex().location());
+        return make_node<Pass>(lex().location());
     case TokenCode::OpenBrace: {
         lex();
         Statements statements;
@@ -131,7 +131,7 @@ std::shared_ptr<Statement> Parser::parse_top_level_statement()
     auto expr = parse_expression();
     if (!expr)
         return nullptr;
-    return std::make_shared<ExpressionStatement>(expr);
+    return make_node<ExpressionStatement>(expr);
 }
 
 std::shared_ptr<Statement> Parser::parse_statement()
@@ -141,7 +141,7 @@ std::shared_ptr<Statement> Parser::parse_statement()
     std::shared_ptr<Statement> ret;
     switch (token.code()) {
     case TokenCode::SemiColon:
-        return std::make_shared<Pass>(lex().location());
+        return make_node<Pass>(lex().location());
     case TokenCode::OpenBrace: {
         lex();
         Statements statements;
@@ -168,7 +168,7 @@ std::shared_ptr<Statement> Parser::parse_statement()
         auto expr = parse_expression();
         if (!expr)
             return nullptr;
-        return std::make_shared<Return>(token.location(), expr);
+        return make_node<Return>(token.location(), expr);
     }
     case TokenCode::Identifier: {
         if (token.value() == "error") {
@@ -176,14 +176,14 @@ std::shared_ptr<Statement> Parser::parse_statement()
             auto expr = parse_expression();
             if (!expr)
                 return nullptr;
-            return std::make_shared<Return>(token.location(), expr, true);
+            return make_node<Return>(token.location(), expr, true);
         }
         break;
     }
     case KeywordBreak:
-        return std::make_shared<Break>(lex().location());
+        return make_node<Break>(lex().location());
     case KeywordContinue:
-        return std::make_shared<Continue>(lex().location());
+        return make_node<Continue>(lex().location());
     case TokenCode::CloseBrace:
     case TokenCode::EndOfFile:
         return nullptr;
@@ -194,7 +194,7 @@ std::shared_ptr<Statement> Parser::parse_statement()
     auto expr = parse_expression();
     if (!expr)
         return nullptr;
-    return std::make_shared<ExpressionStatement>(expr);
+    return make_node<ExpressionStatement>(expr);
 }
 
 void Parser::parse_statements(Statements& block, bool top_level)
@@ -214,7 +214,7 @@ std::shared_ptr<Block> Parser::parse_block(Statements& block)
     if (!expect(TokenCode::CloseBrace)) {
         return nullptr;
     }
-    return std::make_shared<Block>(token.location(), block);
+    return make_node<Block>(token.location(), block);
 }
 
 std::shared_ptr<Statement> Parser::parse_function_definition(Token const& func_token)
@@ -245,7 +245,7 @@ std::shared_ptr<Statement> Parser::parse_function_definition(Token const& func_t
             add_error(peek(), "Syntax Error: Expected type name for parameter {}, got '{}'", param_name_maybe.value(), peek().value());
             return nullptr;
         }
-        params.push_back(std::make_shared<Identifier>(param_name.location(), param_name.value(), param_type));
+        params.push_back(make_node<Identifier>(param_name.location(), param_name.value(), param_type));
         switch (current_code()) {
         case TokenCode::Comma:
             lex();
@@ -269,23 +269,23 @@ std::shared_ptr<Statement> Parser::parse_function_definition(Token const& func_t
         return nullptr;
     }
 
-    auto func_ident = std::make_shared<Identifier>(name.location(), name.value(), type);
+    auto func_ident = make_node<Identifier>(name.location(), name.value(), type);
     std::shared_ptr<FunctionDecl> func_decl;
     if (current_code() == KeywordLink) {
         lex();
         if (auto link_target_maybe = match(TokenCode::DoubleQuotedString, "after '->'"); link_target_maybe.has_value()) {
-            return std::make_shared<NativeFunctionDecl>(name.location(), m_current_module, func_ident, params, link_target_maybe.value().value());
+            return make_node<NativeFunctionDecl>(name.location(), m_current_module, func_ident, params, link_target_maybe.value().value());
         }
         return nullptr;
     }
     if (func_token.code() == KeywordIntrinsic) {
-        return std::make_shared<IntrinsicDecl>(name.location(), m_current_module, func_ident, params);
+        return make_node<IntrinsicDecl>(name.location(), m_current_module, func_ident, params);
     }
-    func_decl = std::make_shared<FunctionDecl>(name.location(), m_current_module, func_ident, params);
+    func_decl = make_node<FunctionDecl>(name.location(), m_current_module, func_ident, params);
     auto stmt = parse_statement();
     if (stmt == nullptr)
         return nullptr;
-    return std::make_shared<FunctionDef>(func_token.location(), func_decl, stmt);
+    return make_node<FunctionDef>(func_token.location(), func_decl, stmt);
 }
 
 std::shared_ptr<IfStatement> Parser::parse_if_statement(Token const& if_token)
@@ -307,17 +307,17 @@ std::shared_ptr<IfStatement> Parser::parse_if_statement(Token const& if_token)
             auto elif_stmt = parse_statement();
             if (!elif_stmt)
                 return nullptr;
-            branches.push_back(std::make_shared<Branch>(elif_token.location(), elif_condition, elif_stmt));
+            branches.push_back(make_node<Branch>(elif_token.location(), elif_condition, elif_stmt));
         } break;
         case KeywordElse: {
             auto else_token = lex();
             auto else_stmt = parse_statement();
             if (!else_stmt)
                 return nullptr;
-            return std::make_shared<IfStatement>(if_token.location(), condition, if_stmt, branches, else_stmt);
+            return make_node<IfStatement>(if_token.location(), condition, if_stmt, branches, else_stmt);
         }
         default:
-            return std::make_shared<IfStatement>(if_token.location(), condition, if_stmt, branches, nullptr);
+            return make_node<IfStatement>(if_token.location(), condition, if_stmt, branches, nullptr);
         }
     }
 }
@@ -345,7 +345,7 @@ std::shared_ptr<SwitchStatement> Parser::parse_switch_statement(Token const& swi
             auto stmt = parse_statement();
             if (!stmt)
                 return nullptr;
-            cases.push_back(std::make_shared<CaseStatement>(case_token.location(), expr, stmt));
+            cases.push_back(make_node<CaseStatement>(case_token.location(), expr, stmt));
         } break;
         case KeywordDefault: {
             auto default_token = lex();
@@ -355,12 +355,12 @@ std::shared_ptr<SwitchStatement> Parser::parse_switch_statement(Token const& swi
             auto stmt = parse_statement();
             if (!stmt)
                 return nullptr;
-            default_case = std::make_shared<DefaultCase>(default_token.location(), stmt);
+            default_case = make_node<DefaultCase>(default_token.location(), stmt);
             break;
         }
         case TokenCode::CloseBrace:
             lex();
-            return std::make_shared<SwitchStatement>(switch_token.location(), switch_expr, cases, default_case);
+            return make_node<SwitchStatement>(switch_token.location(), switch_expr, cases, default_case);
         default:
             add_error(peek(), "Syntax Error: Unexpected token '{}' in switch statement");
             return nullptr;
@@ -380,7 +380,7 @@ std::shared_ptr<WhileStatement> Parser::parse_while_statement(Token const& while
     auto stmt = parse_statement();
     if (!stmt)
         return nullptr;
-    return std::make_shared<WhileStatement>(while_token.location(), condition, stmt);
+    return make_node<WhileStatement>(while_token.location(), condition, stmt);
 }
 
 std::shared_ptr<ForStatement> Parser::parse_for_statement(Token const& for_token)
@@ -406,8 +406,8 @@ std::shared_ptr<ForStatement> Parser::parse_for_statement(Token const& for_token
     auto stmt = parse_statement();
     if (!stmt)
         return nullptr;
-    auto variable_node = std::make_shared<Variable>(variable.value().location(), variable.value().value(), type);
-    return std::make_shared<ForStatement>(for_token.location(), variable_node, expr, stmt);
+    auto variable_node = make_node<Variable>(variable.value().location(), variable.value().value(), type);
+    return make_node<ForStatement>(for_token.location(), variable_node, expr, stmt);
 }
 
 std::shared_ptr<Statement> Parser::parse_struct(Token const& struct_token)
@@ -417,7 +417,7 @@ std::shared_ptr<Statement> Parser::parse_struct(Token const& struct_token)
         return nullptr;
     auto name = identifier_maybe->value();
     if (current_code() != TokenCode::OpenBrace)
-        return std::make_shared<StructForward>(lex().location(), name);
+        return make_node<StructForward>(lex().location(), name);
     lex();
 
     Identifiers fields;
@@ -432,7 +432,7 @@ std::shared_ptr<Statement> Parser::parse_struct(Token const& struct_token)
                 add_error(peek(), "Syntax Error: Expected type after ':', got '{}' ({})", peek().value(), peek().code_name());
                 return nullptr;
             }
-            fields.push_back(std::make_shared<Identifier>(field_name.location(), field_name.value(), field_type));
+            fields.push_back(make_node<Identifier>(field_name.location(), field_name.value(), field_type));
             break;
         }
         case Parser::KeywordFunc: {
@@ -447,7 +447,7 @@ std::shared_ptr<Statement> Parser::parse_struct(Token const& struct_token)
         }
     } while (current_code() != TokenCode::CloseBrace);
     lex();
-    return std::make_shared<StructDefinition>(struct_token.location(), name, fields, methods);
+    return make_node<StructDefinition>(struct_token.location(), name, fields, methods);
 }
 
 std::shared_ptr<VariableDeclaration> Parser::parse_static_variable_declaration()
@@ -493,7 +493,7 @@ std::shared_ptr<VariableDeclaration> Parser::parse_variable_declaration(Token co
         }
         type = var_type;
     }
-    auto var_ident = std::make_shared<Identifier>(identifier.location(), identifier.value(), type);
+    auto var_ident = make_node<Identifier>(identifier.location(), identifier.value(), type);
     std::shared_ptr<Expression> expr { nullptr };
     if (current_code() == TokenCode::Equals) {
         lex();
@@ -508,13 +508,13 @@ std::shared_ptr<VariableDeclaration> Parser::parse_variable_declaration(Token co
     }
     switch (variable_kind) {
     case VariableKind::Local:
-        return std::make_shared<VariableDeclaration>(var_token.location(), var_ident, expr, constant);
+        return make_node<VariableDeclaration>(var_token.location(), var_ident, expr, constant);
     case VariableKind::Static:
-        return std::make_shared<StaticVariableDeclaration>(var_token.location(), var_ident, expr, constant);
+        return make_node<StaticVariableDeclaration>(var_token.location(), var_ident, expr, constant);
     case VariableKind::ModuleLocal:
-        return std::make_shared<LocalVariableDeclaration>(var_token.location(), var_ident, expr, constant);
+        return make_node<LocalVariableDeclaration>(var_token.location(), var_ident, expr, constant);
     case VariableKind::Global:
-        return std::make_shared<GlobalVariableDeclaration>(var_token.location(), var_ident, expr, constant);
+        return make_node<GlobalVariableDeclaration>(var_token.location(), var_ident, expr, constant);
     }
 }
 
@@ -531,8 +531,8 @@ std::shared_ptr<Import> Parser::parse_import_statement(Token const& import_token
         lex();
         module_name += '/';
     }
-    m_ctx.modules.insert(module_name);
-    return std::make_shared<Import>(import_token.location(), module_name);
+    m_ctx.add_module(module_name);
+    return make_node<Import>(import_token.location(), module_name);
 }
 
 /*
@@ -690,7 +690,7 @@ std::shared_ptr<Expression> Parser::parse_expression_1(std::shared_ptr<Expressio
                     }
                 }
                 lex();
-                rhs = std::make_shared<ExpressionList>(op.location(), expressions);
+                rhs = make_node<ExpressionList>(op.location(), expressions);
                 break;
             }
             default: {
@@ -700,7 +700,7 @@ std::shared_ptr<Expression> Parser::parse_expression_1(std::shared_ptr<Expressio
                     if (type == nullptr) {
                         return nullptr;
                     }
-                    return std::make_shared<CastExpression>(lhs->location(), lhs, type);
+                    return make_node<CastExpression>(lhs->location(), lhs, type);
                 }
                 default:
                     rhs = parse_primary_expression();
@@ -720,15 +720,15 @@ std::shared_ptr<Expression> Parser::parse_expression_1(std::shared_ptr<Expressio
         } else {
             rhs = parse_expression();
         }
-        lhs = std::make_shared<BinaryExpression>(lhs, op, rhs);
+        lhs = make_node<BinaryExpression>(lhs, op, rhs);
     }
 
     // Pull up unary expressions with lower precedence than the binary we just parsed.
     // This is for cases like @var.error.
     if (auto binary = std::dynamic_pointer_cast<BinaryExpression>(lhs); binary != nullptr) {
         if (auto lhs_unary = std::dynamic_pointer_cast<UnaryExpression>(binary->lhs()); lhs_unary != nullptr && operator_defs.unary_precedence(lhs_unary->op().code()) < operator_defs.binary_precedence(binary->op().code())) {
-            auto pushed_down = std::make_shared<BinaryExpression>(lhs_unary->operand(), binary->op(), binary->rhs());
-            lhs = std::make_shared<UnaryExpression>(lhs_unary->op(), pushed_down);
+            auto pushed_down = make_node<BinaryExpression>(lhs_unary->operand(), binary->op(), binary->rhs());
+            lhs = make_node<UnaryExpression>(lhs_unary->op(), pushed_down);
         }
     }
     return lhs;
@@ -769,36 +769,36 @@ std::shared_ptr<Expression> Parser::parse_primary_expression()
             }
         }
         expr = (!type_mnemonic.empty())
-            ? std::make_shared<IntLiteral>(t, std::make_shared<ExpressionType>(t.location(), type_mnemonic))
-            : std::make_shared<IntLiteral>(t);
+            ? make_node<IntLiteral>(t, make_node<ExpressionType>(t.location(), type_mnemonic))
+            : make_node<IntLiteral>(t);
         break;
     }
     case TokenCode::Float:
-        expr = std::make_shared<FloatLiteral>(t);
+        expr = make_node<FloatLiteral>(t);
         break;
     case TokenCode::DoubleQuotedString:
-        expr = std::make_shared<StringLiteral>(t);
+        expr = make_node<StringLiteral>(t);
         break;
     case TokenCode::SingleQuotedString:
         if (t.value().length() != 1) {
             add_error(t, "Syntax Error: Single-quoted string should only hold a single character, not '{}'", t.value());
             return nullptr;
         }
-        expr = std::make_shared<CharLiteral>(t);
+        expr = make_node<CharLiteral>(t);
         break;
     case KeywordTrue:
     case KeywordFalse:
-        expr = std::make_shared<BooleanLiteral>(t);
+        expr = make_node<BooleanLiteral>(t);
         break;
     case TokenCode::Identifier:
-        expr = std::make_shared<Variable>(t.location(), t.value());
+        expr = make_node<Variable>(t.location(), t.value());
         break;
     default:
         if (operator_defs.is_unary(t.code())) {
             auto operand = parse_primary_expression();
             if (!operand)
                 return nullptr;
-            expr = std::make_shared<UnaryExpression>(t, operand);
+            expr = make_node<UnaryExpression>(t, operand);
             break;
         }
         add_error(t, "Syntax Error: Expected literal or variable, got '{}' ({})", t.value(), t.code_name());
@@ -821,13 +821,13 @@ std::shared_ptr<ExpressionType> Parser::parse_type()
             switch (current_code()) {
             case TokenCode::DoubleQuotedString: {
                 auto token = lex();
-                arguments.push_back(std::make_shared<StringTemplateArgument>(token.location(), token.value()));
+                arguments.push_back(make_node<StringTemplateArgument>(token.location(), token.value()));
                 break;
             }
             case TokenCode::Integer:
             case TokenCode::HexNumber: {
                 auto token = lex();
-                arguments.push_back(std::make_shared<IntegerTemplateArgument>(token.location(), token_value<long>(token).value()));
+                arguments.push_back(make_node<IntegerTemplateArgument>(token.location(), token_value<long>(token).value()));
                 break;
             }
             case TokenCode::Identifier: {
@@ -844,18 +844,18 @@ std::shared_ptr<ExpressionType> Parser::parse_type()
             }
             if (current_code() == TokenCode::GreaterThan) {
                 lex();
-                return std::make_shared<ExpressionType>(lt_token.location(), type_name, arguments);
+                return make_node<ExpressionType>(lt_token.location(), type_name, arguments);
             }
             if (current_code() == TokenCode::ShiftRight) {
                 replace(Token { TokenCode::GreaterThan, ">" });
-                return std::make_shared<ExpressionType>(lt_token.location(), type_name, arguments);
+                return make_node<ExpressionType>(lt_token.location(), type_name, arguments);
             }
             if (!expect(TokenCode::Comma))
                 return nullptr;
         }
     }
     case TokenCode::Slash: {
-        auto success_type = std::make_shared<ExpressionType>(type_token.location(), type_name);
+        auto success_type = make_node<ExpressionType>(type_token.location(), type_name);
         auto slash = lex();
         if (current_code() != TokenCode::Identifier) {
             add_error(peek(), "Syntax Error: Expected type, got '{}' ({})", peek().value(), peek().code_name());
@@ -864,10 +864,10 @@ std::shared_ptr<ExpressionType> Parser::parse_type()
         auto error_type = parse_type();
         if (error_type == nullptr)
             return nullptr;
-        return std::make_shared<ExpressionType>(slash.location(), "conditional", TemplateArgumentNodes { success_type, error_type });
+        return make_node<ExpressionType>(slash.location(), "conditional", TemplateArgumentNodes { success_type, error_type });
     }
     default:
-        return std::make_shared<ExpressionType>(type_token.location(), type_name);
+        return make_node<ExpressionType>(type_token.location(), type_name);
     }
 }
 
@@ -904,10 +904,10 @@ std::shared_ptr<EnumDef> Parser::parse_enum_definition(Token const& enum_token)
             }
         }
         skip(TokenCode::Comma);
-        values.push_back(std::make_shared<EnumValue>(value_label.location(), value_label.value(), value_value));
+        values.push_back(make_node<EnumValue>(value_label.location(), value_label.value(), value_value));
     }
     lex(); // Eat the closing brace
-    return std::make_shared<EnumDef>(enum_token.location(), name.value(), values, extend);
+    return make_node<EnumDef>(enum_token.location(), name.value(), values, extend);
 }
 
 std::shared_ptr<TypeDef> Parser::parse_type_definition(Token const& type_token)
@@ -921,6 +921,6 @@ std::shared_ptr<TypeDef> Parser::parse_type_definition(Token const& type_token)
     auto type = parse_type();
     if (type == nullptr)
         return nullptr;
-    return std::make_shared<TypeDef>(type_token.location(), name_maybe.value().value(), type);
+    return make_node<TypeDef>(type_token.location(), name_maybe.value().value(), type);
 }
 }
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <map>
+#include <mutex>
 #include <set>
 
 #include <lexer/BasicParser.h>
@@ -18,9 +19,41 @@
 
 namespace Obelix {
 
+// Shared by all parsers of a compilation. Modules are parsed concurrently, so
+// the import queue and the list of source files are guarded by a mutex.
 struct ParserContext {
     Config const& config;
-    std::set<std::string> modules;
+
+    void add_module(std::string const& module_name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_modules.insert(module_name);
+    }
+
+    Strings take_modules()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Strings ret { m_modules.begin(), m_modules.end() };
+        m_modules.clear();
+        return ret;
+    }
+
+    void add_source_file(std::string const& path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_source_files.push_back(path);
+    }
+
+    [[nodiscard]] Strings source_files()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_source_files;
+    }
+
+private:
+    std::mutex m_mutex {};
+    std::set<std::string> m_modules {};
+    Strings m_source_files {};
 };
 
 template<>
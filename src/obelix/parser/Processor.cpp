@@ -4,11 +4,19 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <optional>
+#include <string>
 
+#include <obelix/Hash.h>
+#include <obelix/Parallel.h>
 #include <obelix/Processor.h>
+#include <obelix/Stats.h>
 #include <obelix/Syntax.h>
 #include <obelix/arm64/ARM64.h>
+#include <obelix/parser/ModuleCache.h>
 #include <obelix/parser/Parser.h>
 #include <obelix/transpile/c/CTranspiler.h>
 
@@ -21,6 +29,8 @@ namespace Obelix {
 
 logging_category(processor);
 
+namespace fs = std::filesystem;
+
 std::string sanitize_module_name(std::string const& unsanitized)
 {
     auto ret = to_lower(unsanitized);
@@ -31,17 +41,55 @@ std::string sanitize_module_name(std::string const& unsanitized)
     return ret;
 }
 
+static std::optional<std::string> hash_source_file(std::string const& path)
+{
+    std::ifstream s(path);
+    if (!s.is_open())
+        return {};
+    std::string contents { std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>() };
+    return ContentHash().add(contents).to_string();
+}
+
+static bool use_module_cache(Config const& config)
+{
+    return !config.cmdline_flag<bool>("no-parse-cache") && compiler_build_identity().has_value();
+}
+
 ProcessResult parse(ParserContext& ctx, std::string const& module_name)
 {
+    Stopwatch stopwatch;
+    std::string path;
+    std::optional<std::string> source_hash;
+    if (auto path_or_error = ObelixBufferLocator(ctx.config).locate(module_name); !path_or_error.is_error()) {
+        path = path_or_error.value();
+        if (use_module_cache(ctx.config))
+            source_hash = hash_source_file(path);
+    }
+
+    ProcessResult ret;
+    if (source_hash.has_value() && !ctx.config.cmdline_flag<bool>("force")) {
+        if (auto module = load_cached_module(ctx, module_name, path, source_hash.value()); module != nullptr) {
+            ctx.add_source_file(path);
+            ret = module;
+            CompilerStats::get_stats().add_module_time("load parse tree", module_name, stopwatch);
+            return ret;
+        }
+    }
+
     auto parser_or_error = Parser::create(ctx, module_name);
     if (parser_or_error.is_error()) {
         return SyntaxError { parser_or_error.error().message() };
     }
     auto parser = parser_or_error.value();
-    ProcessResult ret;
-    ret = parser->parse();
+    if (!path.empty())
+        ctx.add_source_file(path);
+    auto module = parser->parse();
+    ret = module;
     for (auto const& e : parser->errors())
         ret.error(e);
+    if (source_hash.has_value() && module != nullptr && !ret.is_error())
+        store_cached_module(module, module_name, path, source_hash.value());
+    CompilerStats::get_stats().add_module_time("parse", module_name, stopwatch);
     return ret;
 }
 
@@ -61,13 +109,112 @@ ProcessResult parse(ParserContext& ctx, std::string const& module_name)
         }                                           \
     })
 
+// The build manifest records the hashes of all source files that went into
+// the executable, preceded by a signature of the build options, the build
+// of the compiler and the runtime it links against. If none of them changed
+// since the last successful build, the executable is current and the whole
+// pipeline can be skipped. Otherwise, only the modules whose source changed
+// are parsed again, and the others are loaded from the module cache.
+static std::string manifest_file_name(Config const& config)
+{
+    return format(".obelix/{}.manifest", config.main());
+}
+
+static std::string build_signature(Config const& config)
+{
+    auto obl_dir = config.obelix_directory();
+    ContentHash hash;
+    auto compiler = config.cmdline_flag<std::string>("with-c-compiler", "cc");
+    hash.add(Architecture_name(config.target))
+        .add(obl_dir)
+        .add(config.import_root ? "root" : "no-root")
+        .add(compiler)
+        .add(config.cmdline_flag<std::string>("with-c-linker", compiler))
+        .add(config.cmdline_flag<bool>("no-direct-intrinsics") ? "no-direct-intrinsics" : "direct-intrinsics")
+        .add(config.cmdline_flag<bool>("no-string-moves") ? "no-string-moves" : "string-moves")
+        .add(config.cmdline_flag<bool>("in-process-cc") ? "in-process-cc" : "cc")
+        .add(compiler_build_identity().value_or(""))
+        .add(hash_source_file(format("{}/include/obelix.h", obl_dir)).value_or(""))
+        .add(hash_source_file(format("{}/lib/liboblcrt.a", obl_dir)).value_or(""));
+    return hash.to_string();
+}
+
+static bool incremental_build_possible(Config const& config)
+{
+    return config.target == Architecture::C_TRANSPILER && config.bind && config.lower && config.fold_constants && config.compile
+        && compiler_build_identity().has_value()
+        && !config.cmdline_flag<bool>("force") && !config.cmdline_flag<bool>("show-tree")
+        && !config.cmdline_flag<bool>("show-c-file") && !config.cmdline_flag<bool>("keep-c-file")
+        && !(config.run && config.cmdline_flag<bool>("in-process-cc"));
+}
+
+static bool build_is_up_to_date(Config const& config)
+{
+    std::error_code ec;
+    if (!fs::exists(config.main(), ec))
+        return false;
+    std::ifstream manifest(manifest_file_name(config));
+    if (!manifest.is_open())
+        return false;
+    std::string line;
+    if (!std::getline(manifest, line) || line != build_signature(config))
+        return false;
+    auto num_sources = 0;
+    while (std::getline(manifest, line)) {
+        auto space = line.find(' ');
+        if (space == std::string::npos)
+            return false;
+        auto hash = hash_source_file(line.substr(space + 1));
+        if (!hash.has_value() || hash.value() != line.substr(0, space)) {
+            debug(processor, "Source file '{}' changed since last build", line.substr(space + 1));
+            return false;
+        }
+        ++num_sources;
+    }
+    return num_sources > 0;
+}
+
+static void write_build_manifest(Config const& config, Strings const& source_files)
+{
+    std::ofstream manifest(manifest_file_name(config));
+    if (!manifest.is_open())
+        return;
+    manifest << build_signature(config) << "\n";
+    for (auto const& file : source_files) {
+        if (auto hash = hash_source_file(file); hash.has_value())
+            manifest << hash.value() << " " << file << "\n";
+    }
+}
+
 ProcessResult compile_project(Config const& config)
 {
     ParserContext ctx { config };
+    auto& stats = CompilerStats::get_stats();
+    Stopwatch stopwatch;
+
+    auto incremental = incremental_build_possible(config);
+    if (incremental) {
+        auto up_to_date = build_is_up_to_date(config);
+        stats.add_phase("check manifest", stopwatch);
+        if (up_to_date) {
+            debug(processor, "'{}' is up to date", config.main());
+            ProcessResult result;
+            if (config.run)
+                return run_executable(result, config);
+            result = std::make_shared<BoundIntLiteral>(Span {}, 0);
+            return result;
+        }
+        std::error_code ec;
+        fs::remove(manifest_file_name(config), ec);
+    }
 
     ProcessResult result;
     result = std::make_shared<Compilation>(config.main());
+    stopwatch.reset();
     process(result.value(), ctx, result);
+    stats.add_phase("parse", stopwatch, result.value());
+    if (use_module_cache(config))
+        trim_module_cache();
     if (result.is_error())
         return result;
     if (config.cmdline_flag<bool>("show-tree"))
@@ -76,11 +223,15 @@ ProcessResult compile_project(Config const& config)
     if (!config.bind)
         return result;
 
+    stopwatch.reset();
     bind_types(config, result);
+    stats.add_phase("bind", stopwatch, result.value());
     if (result.is_error() || !config.lower)
         return result;
 
+    stopwatch.reset();
     lower(config, result);
+    stats.add_phase("lower", stopwatch, result.value());
     if (result.is_error())
         return result;
     if (config.cmdline_flag<bool>("show-tree"))
@@ -89,7 +240,9 @@ ProcessResult compile_project(Config const& config)
     if (!config.fold_constants)
         return result;
 
+    stopwatch.reset();
     fold_constants(result);
+    stats.add_phase("fold", stopwatch, result.value());
     if (result.is_error())
         return result;
     if (config.cmdline_flag<bool>("show-tree"))
@@ -100,7 +253,9 @@ ProcessResult compile_project(Config const& config)
 
     switch (config.target) {
     case Architecture::MACOS_ARM64: {
+        stopwatch.reset();
         output_arm64(result, config);
+        stats.add_phase("arm64", stopwatch);
         if (result.is_error())
             return result;
         if (result.value() == nullptr || result.value()->node_type() != SyntaxNodeType::BoundIntLiteral)
@@ -109,6 +264,8 @@ ProcessResult compile_project(Config const& config)
     }
     case Architecture::C_TRANSPILER: {
         transpile_to_c(result, config);
+        if (incremental && !result.is_error())
+            write_build_manifest(config, ctx.source_files());
         if (result.value() == nullptr || result.value()->node_type() != SyntaxNodeType::BoundIntLiteral)
             result = std::make_shared<BoundIntLiteral>(Span {}, 0);
         return result;
@@ -144,17 +301,18 @@ NODE_PROCESSOR(Compilation)
         if (result.is_error())
             return result.error();
         modules.push_back(std::dynamic_pointer_cast<Module>(res.value()));
-        while (!ctx.modules.empty()) {
-            Strings module_names;
-            for (auto const& m : ctx.modules) {
-                module_names.push_back(m);
-            }
-            ctx.modules.clear();
-            for (auto const& m : module_names) {
-                res = parse(ctx, m);
-                if (res.has_value())
-                    modules.push_back(std::dynamic_pointer_cast<Module>(res.value()));
-                result += res;
+        for (auto module_names = ctx.take_modules(); !module_names.empty(); module_names = ctx.take_modules()) {
+            // Every module of a wave gets its own Parser, so they can be
+            // parsed concurrently. Results are merged in module name order
+            // to keep the order of Compilation::modules() stable.
+            std::vector<ProcessResult> wave(module_names.size());
+            parallel_for(module_names.size(), ctx.config.jobs, [&ctx, &module_names, &wave](size_t ix) {
+                wave[ix] = parse(ctx, module_names[ix]);
+            });
+            for (auto const& module_result : wave) {
+                if (module_result.has_value())
+                    modules.push_back(std::dynamic_pointer_cast<Module>(module_result.value()));
+                result += module_result;
             }
         }
     }
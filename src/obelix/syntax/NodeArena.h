@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <memory_resource>
+
+namespace Obelix {
+
+// Backing store for syntax nodes. While a NodeArena exists, make_node
+// allocates the nodes created on the thread that created it from a pool
+// owned by the arena instead of from the global heap. Memory of nodes that
+// are dropped is reused for the nodes of the next pass, and everything is
+// released in one go when the arena goes away.
+//
+// Nodes are still handed out as std::shared_ptr, and the arena does not
+// keep them alive, so it must outlive every node allocated from it. The
+// pool is not synchronized: nodes allocated from an arena must only be
+// released on the thread that owns it.
+class NodeArena {
+public:
+    NodeArena()
+        : m_previous(s_current)
+    {
+        s_current = this;
+    }
+
+    ~NodeArena()
+    {
+        s_current = m_previous;
+    }
+
+    NodeArena(NodeArena const&) = delete;
+    NodeArena& operator=(NodeArena const&) = delete;
+
+    [[nodiscard]] static NodeArena* current() { return s_current; }
+
+    template<typename T>
+    [[nodiscard]] std::pmr::polymorphic_allocator<T> allocator() { return { &m_pool }; }
+
+private:
+    std::pmr::unsynchronized_pool_resource m_pool {};
+    NodeArena* m_previous;
+    static inline thread_local NodeArena* s_current { nullptr };
+};
+
+}
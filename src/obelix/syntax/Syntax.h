@@ -11,10 +11,12 @@
 #include <string>
 #include <vector>
 
+#include <config.h>
 #include <core/Logging.h>
 #include <lexer/Token.h>
 #include <obelix/SyntaxNodeType.h>
 #include <obelix/Type.h>
+#include <obelix/syntax/NodeArena.h>
 
 namespace Obelix {
 
@@ -117,8 +119,16 @@ std::string m_tag;
 template<class T, class... Args>
 std::shared_ptr<T> make_node(Args&&... args)
 {
-    auto ret = std::make_shared<T>(std::forward<Args>(args)...);
-    debug(parser, "{}: {}", SyntaxNodeType_name(ret->node_type()), ret->to_string());
+    std::shared_ptr<T> ret;
+    if (auto arena = NodeArena::current(); arena != nullptr)
+        ret = std::allocate_shared<T>(arena->allocator<T>(), std::forward<Args>(args)...);
+    else
+        ret = std::make_shared<T>(std::forward<Args>(args)...);
+#if OBELIX_TRACE
+    if (parser_logger.enabled()) {
+        debug(parser, "{}: {}", SyntaxNodeType_name(ret->node_type()), ret->to_string());
+    }
+#endif
     return ret;
 }
 
@@ -5,14 +5,24 @@
  */
 
 #include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <set>
+#include <string_view>
 
 #include <core/Error.h>
 #include <core/Logging.h>
 #include <core/Process.h>
+#include <obelix/Cache.h>
+#include <obelix/Hash.h>
+#include <obelix/Parallel.h>
 #include <obelix/Processor.h>
+#include <obelix/Stats.h>
 #include <obelix/transpile/c/CTranspiler.h>
 #include <obelix/transpile/c/CTranspilerIntrinsics.h>
 #include <obelix/transpile/c/CTranspilerContext.h>
@@ -164,6 +174,122 @@ void function_decl(CTranspilerContext& ctx, pBoundFunctionDecl const& function,
     write(ctx, ")");
 }
 
+//
+// Strings are reference counted. A string expression evaluates to a
+// reference that is owned by whoever uses the value, so reading a string
+// variable normally means incrementing its reference count. Some of that
+// traffic is avoided:
+//
+// - Functions only borrow their string arguments; the caller releases them
+//   after the call. A function therefore never releases or modifies the
+//   string a parameter refers to: parameters are not moved out of, and
+//   s = s + piece only appends in place to locals. Given that, local
+//   variables and parameters are lent to the function called as they are,
+//   unless one of the arguments assigns to a variable.
+// - If a statement is the last use of a local variable, its value is moved
+//   out of the variable instead of copied. The variable is set to NULL, so
+//   releasing it at the end of its block is a no-op. Returning a local
+//   variable is always its last use.
+//
+// --no-string-moves turns this off.
+//
+
+enum class VariableScope {
+    Local,
+    Parameter,
+    Other,
+};
+
+VariableScope variable_scope(CTranspilerContext& ctx, std::string const& name)
+{
+    for (auto c = &ctx; c != nullptr; c = c->parent()) {
+        if (c->names().contains(name)) {
+            auto var_decl = std::dynamic_pointer_cast<BoundVariableDeclaration>(c->names().at(name));
+            return (var_decl != nullptr && !var_decl->is_static()) ? VariableScope::Local : VariableScope::Other;
+        }
+        if (auto const& function = c->data().function; function != nullptr) {
+            auto const& params = function->parameters();
+            if (std::any_of(params.begin(), params.end(), [&name](auto const& param) { return param->name() == name; }))
+                return VariableScope::Parameter;
+            break;
+        }
+    }
+    return VariableScope::Other;
+}
+
+bool references_variable(std::shared_ptr<SyntaxNode> const& node, std::string const& name)
+{
+    if (node == nullptr)
+        return false;
+    if (auto identifier = std::dynamic_pointer_cast<BoundIdentifier>(node); identifier != nullptr && identifier->name() == name)
+        return true;
+    if (auto method_call = std::dynamic_pointer_cast<BoundMethodCall>(node); method_call != nullptr && references_variable(method_call->self(), name))
+        return true;
+    auto children = node->children();
+    return std::any_of(children.begin(), children.end(), [&name](auto const& child) { return references_variable(child, name); });
+}
+
+bool contains_assignment(std::shared_ptr<SyntaxNode> const& node)
+{
+    if (node == nullptr)
+        return false;
+    if (std::dynamic_pointer_cast<BoundAssignment>(node) != nullptr)
+        return true;
+    if (auto method_call = std::dynamic_pointer_cast<BoundMethodCall>(node); method_call != nullptr && contains_assignment(method_call->self()))
+        return true;
+    auto children = node->children();
+    return std::any_of(children.begin(), children.end(), [](auto const& child) { return contains_assignment(child); });
+}
+
+// Only Obelix functions are lent strings. Native functions can do anything
+// with their arguments, like holding on to them without taking a reference.
+pBoundVariable borrowed_argument(CTranspilerContext& ctx, pBoundFunctionCall const& call, pBoundExpression const& arg)
+{
+    if (ctx.config().cmdline_flag<bool>("no-string-moves"))
+        return nullptr;
+    if (std::dynamic_pointer_cast<BoundNativeFunctionCall>(call) != nullptr)
+        return nullptr;
+    auto variable = std::dynamic_pointer_cast<BoundVariable>(arg);
+    if (variable == nullptr || variable->type()->type() != PrimitiveType::String)
+        return nullptr;
+    if (variable_scope(ctx, variable->name()) == VariableScope::Other)
+        return nullptr;
+    if (std::any_of(call->arguments().begin(), call->arguments().end(), [](auto const& a) { return contains_assignment(a); }))
+        return nullptr;
+    return variable;
+}
+
+pBoundVariable moved_variable(CTranspilerContext& ctx, pBlock const& block, size_t ix)
+{
+    if (ctx.config().cmdline_flag<bool>("no-string-moves"))
+        return nullptr;
+    auto const& stmt = block->statements()[ix];
+    if (auto ret = std::dynamic_pointer_cast<BoundReturn>(stmt); ret != nullptr) {
+        auto variable = std::dynamic_pointer_cast<BoundVariable>(ret->expression());
+        if (variable == nullptr || variable->type()->type() != PrimitiveType::String || variable_scope(ctx, variable->name()) != VariableScope::Local)
+            return nullptr;
+        return variable;
+    }
+
+    pBoundExpression value { nullptr };
+    if (auto var_decl = std::dynamic_pointer_cast<BoundVariableDeclaration>(stmt); var_decl != nullptr && !var_decl->is_static()) {
+        value = var_decl->expression();
+    } else if (auto expr_stmt = std::dynamic_pointer_cast<BoundExpressionStatement>(stmt); expr_stmt != nullptr) {
+        if (auto assignment = std::dynamic_pointer_cast<BoundAssignment>(expr_stmt->expression()); assignment != nullptr)
+            value = assignment->expression();
+    }
+    auto variable = std::dynamic_pointer_cast<BoundVariable>(value);
+    if (variable == nullptr || variable->type()->type() != PrimitiveType::String)
+        return nullptr;
+    if (!ctx.names().contains(variable->name()) || variable_scope(ctx, variable->name()) != VariableScope::Local)
+        return nullptr;
+    for (auto jx = ix + 1; jx < block->statements().size(); ++jx) {
+        if (references_variable(block->statements()[jx], variable->name()))
+            return nullptr;
+    }
+    return variable;
+}
+
 template <typename EmitFunction>
 ErrorOr<void, SyntaxError> function_call(CTranspilerContext& ctx, ProcessResult& result, pBoundFunctionCall const& call, EmitFunction const& emitter)
 {
@@ -176,10 +302,17 @@ ErrorOr<void, SyntaxError> function_call(CTranspilerContext& ctx, ProcessResult&
         writeln(ctx, ";");
     }
     auto count { 0 };
+    std::vector<bool> borrowed;
     for (auto const& arg : call->arguments()) {
         type_to_c_type(ctx, arg->type());
         write(ctx, format(" $arg{} = ", count++));
-        TRY_RETURN(process(arg, ctx));
+        if (auto variable = borrowed_argument(ctx, call, arg); variable != nullptr) {
+            write(ctx, variable->name());
+            borrowed.push_back(true);
+        } else {
+            TRY_RETURN(process(arg, ctx));
+            borrowed.push_back(false);
+        }
         writeln(ctx, ";");
     }
     if (call->type()->type() != PrimitiveType::Void)
@@ -189,7 +322,7 @@ ErrorOr<void, SyntaxError> function_call(CTranspilerContext& ctx, ProcessResult&
     count = 0;
     for (auto const& arg : call->arguments()) {
         auto method_descr = arg->type()->get_method(Operator::Destructor, {});
-        if (method_descr != nullptr) {
+        if (method_descr != nullptr && !borrowed[count]) {
             writeln(ctx, "({");
             indent(ctx);
             writeln(ctx, format("{} $self = $arg{};", type_to_c_type(arg->type()), count));
@@ -209,11 +342,104 @@ ErrorOr<void, SyntaxError> function_call(CTranspilerContext& ctx, ProcessResult&
     return {};
 }
 
+bool has_side_effects(pBoundExpression const&);
+bool is_constant(pBoundExpression const&);
+
+// && and || evaluate their operands from left to right, and only as far as
+// needed to know the result.
+bool is_short_circuit_intrinsic(IntrinsicType intrinsic)
+{
+    return intrinsic == IntrinsicType::and_bool_bool || intrinsic == IntrinsicType::or_bool_bool;
+}
+
+// Calls to pure intrinsics, like integer arithmetic, are emitted as the C
+// expression of the intrinsic with the arguments substituted, instead of
+// as a statement expression with a temporary for every argument. This is
+// only possible if none of the arguments have to be destroyed after the
+// call. Furthermore C doesn't define the order in which the operands of
+// most operators are evaluated, and a side effect could change a variable
+// another operand reads. So if an argument has side effects all other
+// arguments must be constants, unless the intrinsic short-circuits.
+bool is_direct_intrinsic_call(pBoundIntrinsicCall const& call)
+{
+    if (get_c_transpiler_expression(call->intrinsic()).empty())
+        return false;
+    auto side_effects { 0 };
+    auto non_constants { 0 };
+    for (auto const& arg : call->arguments()) {
+        if (arg->type()->get_method(Operator::Destructor, {}) != nullptr)
+            return false;
+        if (has_side_effects(arg))
+            ++side_effects;
+        if (!is_constant(arg))
+            ++non_constants;
+    }
+    return is_short_circuit_intrinsic(call->intrinsic()) || side_effects == 0 || non_constants <= 1;
+}
+
+bool is_constant(pBoundExpression const& expr)
+{
+    if (std::dynamic_pointer_cast<BoundLiteral>(expr) != nullptr || std::dynamic_pointer_cast<BoundEnumValue>(expr) != nullptr)
+        return true;
+    if (auto cast = std::dynamic_pointer_cast<BoundCastExpression>(expr); cast != nullptr)
+        return is_constant(cast->expression());
+    if (auto call = std::dynamic_pointer_cast<BoundIntrinsicCall>(expr); call != nullptr && is_direct_intrinsic_call(call)) {
+        return std::all_of(call->arguments().begin(), call->arguments().end(), [](auto const& arg) {
+            return is_constant(arg);
+        });
+    }
+    return false;
+}
+
+bool has_side_effects(pBoundExpression const& expr)
+{
+    if (std::dynamic_pointer_cast<BoundLiteral>(expr) != nullptr
+        || std::dynamic_pointer_cast<BoundEnumValue>(expr) != nullptr
+        || std::dynamic_pointer_cast<BoundIdentifier>(expr) != nullptr)
+        return false;
+    if (auto cast = std::dynamic_pointer_cast<BoundCastExpression>(expr); cast != nullptr)
+        return has_side_effects(cast->expression());
+    if (auto call = std::dynamic_pointer_cast<BoundIntrinsicCall>(expr); call != nullptr && is_direct_intrinsic_call(call)) {
+        return std::any_of(call->arguments().begin(), call->arguments().end(), [](auto const& arg) {
+            return has_side_effects(arg);
+        });
+    }
+    return true;
+}
+
+ErrorOr<void, SyntaxError> direct_intrinsic_call(CTranspilerContext& ctx, pBoundIntrinsicCall const& call)
+{
+    // C promotes operands narrower than int, so the result is cast back to
+    // the type of the call to get the same wrap-around as the intrinsic.
+    auto const& expression = get_c_transpiler_expression(call->intrinsic());
+    write(ctx, format("(({})(", type_to_c_type(call->type())));
+    size_t pos = 0;
+    for (auto ix = expression.find("$arg"); ix != std::string::npos; ix = expression.find("$arg", pos)) {
+        write(ctx, expression.substr(pos, ix - pos));
+        pos = ix + 4;
+        size_t arg = 0;
+        while (pos < expression.length() && isdigit(expression[pos]))
+            arg = arg * 10 + (expression[pos++] - '0');
+        assert(arg < call->arguments().size());
+        write(ctx, "(");
+        TRY_RETURN(process(call->arguments()[arg], ctx));
+        write(ctx, ")");
+    }
+    write(ctx, expression.substr(pos));
+    write(ctx, "))");
+    return {};
+}
+
 ErrorOr<void,SyntaxError> transpile_block(pBlock const& block, CTranspilerContext& ctx, ProcessResult& result)
 {
     CTranspilerContext& block_ctx = make_subcontext<CTranspilerContext>(ctx);
-    for (auto& stmt : block->statements()) {
+    if (auto function_block = std::dynamic_pointer_cast<FunctionBlock>(block); function_block != nullptr)
+        block_ctx().function = function_block->declaration();
+    for (auto ix = 0u; ix < block->statements().size(); ++ix) {
+        auto const& stmt = block->statements()[ix];
+        block_ctx().moved_variable = moved_variable(block_ctx, block, ix);
         TRY_RETURN(process(stmt, block_ctx, result));
+        block_ctx().moved_variable = nullptr;
         if (auto child_block = std::dynamic_pointer_cast<Block>(stmt); child_block != nullptr) {
             writeln(ctx, format("if ($return_triggered) goto {};", exit_label(block_ctx)));
         }
@@ -283,7 +509,7 @@ R"(/*
             }
             dedent(ctx);
             writeln(ctx, format("} {};\n", type->name()));
-            writeln(ctx, format("extern $enum_value $_{}_values[];", type->name()));
+            writeln(ctx, format("extern $enum_table $_{}_table;", type->name()));
             break;
         }
         case PrimitiveType::Array: {
@@ -405,14 +631,38 @@ NODE_PROCESSOR(FunctionBlock)
 NODE_PROCESSOR(BoundEnumDef)
 {
     auto enum_def = std::dynamic_pointer_cast<BoundEnumDef>(tree);
-    writeln(ctx, format("$enum_value $_{}_values[] = {", enum_def->type()->name()));
-    indent(ctx);
+    auto name = enum_def->type()->name();
+
+    // Values are looked up by value. If a value is used more than once, the
+    // first label wins.
+    NVPs values;
+    std::set<long> seen;
     for (auto const& v : enum_def->type()->template_argument_values<NVP>("values")) {
+        if (seen.insert(v.second).second)
+            values.push_back(v);
+    }
+    std::sort(values.begin(), values.end(), [](NVP const& v1, NVP const& v2) { return v1.second < v2.second; });
+
+    // Enums with no or only small gaps between their values get a table
+    // indexed by value. Others get a sorted table that is searched.
+    auto base = (values.empty()) ? 0 : values.front().second;
+    auto range = (values.empty()) ? 0 : values.back().second - base + 1;
+    auto dense = range <= 2 * static_cast<long>(values.size());
+
+    writeln(ctx, format("$enum_value $_{}_values[] = {", name));
+    indent(ctx);
+    auto size = 0ul;
+    for (auto const& v : values) {
+        for (auto hole = base + static_cast<long>(size); dense && hole < v.second; ++hole, ++size)
+            writeln(ctx, format("{{{}, NULL},", hole));
         writeln(ctx, format("{{{}, \"{}\"},", v.second, v.first));
+        ++size;
     }
     writeln(ctx, "{ 0, NULL }");
     dedent(ctx);
     writeln(ctx, "};\n");
+    writeln(ctx, format("$enum_table $_{}_table = {{ {}, {}, {}, $_{}_values };\n",
+        name, (dense) ? "$enum_dense" : "$enum_sorted", base, size, name));
     return tree;
 }
 
@@ -482,6 +732,14 @@ NODE_PROCESSOR(BoundNativeFunctionCall)
 NODE_PROCESSOR(BoundIntrinsicCall)
 {
     auto call = std::dynamic_pointer_cast<BoundIntrinsicCall>(tree);
+    // Logical and and or are always emitted as && and ||, even with
+    // --no-direct-intrinsics, so the right hand side is only evaluated if
+    // it's needed.
+    auto direct = is_short_circuit_intrinsic(call->intrinsic()) || !ctx.config().cmdline_flag<bool>("no-direct-intrinsics");
+    if (direct && is_direct_intrinsic_call(call)) {
+        TRY_RETURN(direct_intrinsic_call(ctx, call));
+        return tree;
+    }
     TRY_RETURN(function_call(ctx, result, call, [&call, &ctx]() -> ErrorOr<void, SyntaxError> {
         CTranspilerFunctionType impl = get_c_transpiler_intrinsic(call->intrinsic());
         if (!impl)
@@ -535,7 +793,8 @@ NODE_PROCESSOR(BoundStringLiteral)
     auto literal = std::dynamic_pointer_cast<BoundStringLiteral>(tree);
     auto s = literal->value();
     replace_all(s, "\n", "\\n");
-    write(ctx, format(R"(str_view_for("{}"))", s));
+    // Every literal is interned once, the first time it's evaluated.
+    write(ctx, format(R"(({{ static string $literal = NULL; str_literal(&$literal, "{}"); }))", s));
     return tree;
 }
 
@@ -551,6 +810,8 @@ NODE_PROCESSOR(BoundVariable)
     auto variable = std::dynamic_pointer_cast<BoundVariable>(tree);
     if (variable->type()->type() != PrimitiveType::String)
         write(ctx, variable->name());
+    else if (variable == ctx().moved_variable)
+        write(ctx, format("({{ string $moved = {}; {} = NULL; $moved; })", variable->name(), variable->name()));
     else
         write(ctx, format("str_copy({})", variable->name()));
     return tree;
@@ -636,9 +897,44 @@ NODE_PROCESSOR(BoundArrayAccess)
     return tree;
 }
 
+// Recognizes s = s + <expr> for a local string variable s, which is what
+// building a string in a loop looks like. Returns the <expr> bit, or nullptr
+// if the assignment doesn't look like that. Parameters are borrowed from the
+// caller, and str_append would release or grow the caller's string, so they
+// are left to add_str_str.
+static std::shared_ptr<BoundExpression> string_accumulation(CTranspilerContext& ctx, std::shared_ptr<BoundAssignment> const& assignment)
+{
+    auto assignee = std::dynamic_pointer_cast<BoundIdentifier>(assignment->assignee());
+    if (assignee == nullptr || assignee->type()->type() != PrimitiveType::String)
+        return nullptr;
+    if (variable_scope(ctx, assignee->name()) != VariableScope::Local)
+        return nullptr;
+    auto call = std::dynamic_pointer_cast<BoundIntrinsicCall>(assignment->expression());
+    if (call == nullptr || call->intrinsic() != IntrinsicType::add_str_str || call->arguments().size() != 2)
+        return nullptr;
+    auto lhs = std::dynamic_pointer_cast<BoundIdentifier>(call->arguments()[0]);
+    if (lhs == nullptr || lhs->name() != assignee->name())
+        return nullptr;
+    return call->arguments()[1];
+}
+
 NODE_PROCESSOR(BoundAssignment)
 {
     auto assignment = std::dynamic_pointer_cast<BoundAssignment>(tree);
+    if (auto piece = string_accumulation(ctx, assignment); piece != nullptr) {
+        // str_append takes over the variable's reference to the current
+        // value, so it can grow the string in place instead of copying it.
+        auto name = std::dynamic_pointer_cast<BoundIdentifier>(assignment->assignee())->name();
+        writeln(ctx, format("{} = ({{", name));
+        indent(ctx);
+        write(ctx, "string $piece = ");
+        TRY_RETURN(process(piece, ctx));
+        writeln(ctx, ";");
+        writeln(ctx, format("str_append({}, $piece);", name));
+        dedent(ctx);
+        write(ctx, "})");
+        return tree;
+    }
     TRY_RETURN(process(assignment->assignee(), ctx));
     write(ctx, " = ");
     TRY_RETURN(process(assignment->expression(), ctx));
@@ -766,13 +1062,94 @@ NODE_PROCESSOR(BoundSwitchStatement)
     return tree;
 }
 
+struct CCompileJob {
+    std::string module_name;
+    std::vector<std::string> cc_args;
+    fs::path o_file;
+    fs::path cache_file;
+    int exit_code { -1 };
+    std::optional<SystemError> error {};
+    std::string standard_error {};
+};
+
+// Runs the C compiler for every job, with at most max_jobs compilers running
+// concurrently. Results are stored in the job itself so the caller can report
+// them in module order, regardless of the order in which the compilers finish.
+static void compile_c_modules(std::vector<CCompileJob>& jobs, std::string const& compiler, unsigned int max_jobs)
+{
+    parallel_for(jobs.size(), max_jobs, [&jobs, &compiler](size_t ix) {
+        auto& job = jobs[ix];
+        debug(c_transpiler, "Compiling '{}'", job.module_name);
+        Stopwatch stopwatch;
+        Process cc(compiler, job.cc_args);
+        if (auto code = cc.execute(); code.is_error()) {
+            job.error = code.error();
+        } else {
+            job.exit_code = code.value();
+        }
+        CompilerStats::get_stats().add_process("cc", job.module_name, compiler, stopwatch, job.exit_code);
+        job.standard_error = cc.standard_error();
+    });
+}
+
+// Objects are cached in .obelix/cache, keyed on a hash of everything that
+// determines the contents of the object file: the build of the compiler,
+// its flags, the runtime header, and the hashes of the generated project
+// header and the module's C text.
+static std::string object_cache_key(std::string const& compiler_identity, std::vector<std::string> const& cc_flags, std::vector<std::string_view> const& sources)
+{
+    ContentHash hash;
+    hash.add(compiler_identity);
+    for (auto const& flag : cc_flags)
+        hash.add(flag);
+    for (auto const& source : sources)
+        hash.add(source);
+    return hash.to_string();
+}
+
+// Least recently used objects are evicted beyond this many cache entries.
+constexpr static size_t MaxCachedObjects = 1024;
+
+// Finds the executable a command runs, searching PATH like the shell does.
+static fs::path resolve_executable(std::string const& command)
+{
+    if (command.find('/') != std::string::npos)
+        return command;
+    auto path = getenv("PATH");
+    if (path == nullptr)
+        return command;
+    std::string_view dirs { path };
+    while (!dirs.empty()) {
+        auto colon = dirs.find(':');
+        auto dir = dirs.substr(0, colon);
+        auto candidate = fs::path((dir.empty()) ? "." : dir) / command;
+        if (access(candidate.c_str(), X_OK) == 0)
+            return candidate;
+        if (colon == std::string_view::npos)
+            break;
+        dirs.remove_prefix(colon + 1);
+    }
+    return command;
+}
+
+static std::string read_runtime_header()
+{
+    std::ifstream s(format("{}/include/obelix.h", obl_dir));
+    if (!s.is_open())
+        return "";
+    return std::string { std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>() };
+}
+
 ProcessResult& transpile_to_c(ProcessResult& result, Config const& config)
 {
     CTranspilerContext root(config);
     obl_dir = config.obelix_directory();
     fs::create_directory(".obelix");
 
+    auto& stats = CompilerStats::get_stats();
+    Stopwatch stopwatch;
     process(result.value(), root, result);
+    stats.add_phase("generate C", stopwatch);
 
     if (result.is_error())
         return result;
@@ -807,6 +1184,27 @@ ProcessResult& transpile_to_c(ProcessResult& result, Config const& config)
     auto compiler = config.cmdline_flag<std::string>("with-c-compiler", "cc");
     auto linker = config.cmdline_flag<std::string>("with-c-linker", compiler);
 
+    std::vector<std::string> cc_flags = { format("-I{}/include", obl_dir), "-O3" };
+    auto in_process = config.cmdline_flag<bool>("in-process-cc");
+    auto use_cache = !in_process && !config.cmdline_flag<bool>("no-object-cache");
+    auto cache_dir = fs::path(".obelix") / "cache";
+    std::string runtime_header;
+    std::string compiler_identity;
+    if (use_cache) {
+        // Without knowing which build of the compiler runs, objects of an
+        // older toolchain could be picked up, so the cache isn't used:
+        auto stamp = file_stamp(resolve_executable(compiler));
+        use_cache = stamp.has_value();
+        if (use_cache) {
+            compiler_identity = stamp.value();
+            fs::create_directory(cache_dir);
+            runtime_header = read_runtime_header();
+        }
+    }
+
+    stopwatch.reset();
+    std::vector<fs::path> c_files;
+    std::vector<CCompileJob> jobs;
     for (auto& module_file : files(root)) {
         auto p = fs::path(".obelix") / module_file->name();
         output_files.push_back(p);
@@ -816,20 +1214,60 @@ ProcessResult& transpile_to_c(ProcessResult& result, Config const& config)
         }
         if (module_file->name().ends_with(".h"))
             continue;
+        if (in_process) {
+            c_files.push_back(p);
+            continue;
+        }
         auto o_file = p;
         o_file.replace_extension("o");
         unlink(o_file.c_str());
-        std::vector<std::string> cc_args = { p.string(), "-c", "-o", o_file, format("-I{}/include", obl_dir), "-O3" };
-        if (auto code = execute(compiler, cc_args); code.is_error() || (code.value() != 0)) {
-            if (code.is_error()) {
-                result.error(SyntaxError { "Compilation of '{}' failed: {}", module_file->name(), code.error() });
-            } else {
-                result.error(SyntaxError { "Compilation of '{}' failed", module_file->name() });
+        modules.push_back(o_file);
+
+        fs::path cache_file;
+        if (use_cache) {
+            auto key = object_cache_key(compiler_identity, cc_flags, { runtime_header, root().header->content_hash(), module_file->content_hash() });
+            cache_file = cache_dir / (key + ".o");
+            std::error_code ec;
+            if (fs::exists(cache_file, ec) && fs::copy_file(cache_file, o_file, fs::copy_options::overwrite_existing, ec)) {
+                debug(c_transpiler, "Object file for '{}' found in cache", module_file->name());
+                touch_cache_entry(cache_file);
+                continue;
             }
-            return result;
         }
-        modules.push_back(o_file);
+
+        std::vector<std::string> cc_args = { p.string(), "-c", "-o", o_file };
+        cc_args.insert(cc_args.end(), cc_flags.begin(), cc_flags.end());
+        jobs.push_back({ module_file->name(), cc_args, o_file, cache_file });
+    }
+
+    if (in_process) {
+        compile_c_in_process(result, config, c_files);
+        if (!config.cmdline_flag<bool>("keep-c-file")) {
+            for (auto const& file : output_files)
+                unlink(file.c_str());
+        }
+        return result;
     }
+
+    compile_c_modules(jobs, compiler, config.jobs);
+    stats.add_phase("cc", stopwatch);
+    for (auto const& job : jobs) {
+        if (!job.standard_error.empty())
+            std::cerr << job.standard_error;
+        if (job.error.has_value()) {
+            result.error(SyntaxError { "Compilation of '{}' failed: {}", job.module_name, job.error.value() });
+        } else if (job.exit_code != 0) {
+            result.error(SyntaxError { "Compilation of '{}' failed", job.module_name });
+        } else if (!job.cache_file.empty()) {
+            std::error_code ec;
+            if (!fs::copy_file(job.o_file, job.cache_file, fs::copy_options::overwrite_existing, ec))
+                debug(c_transpiler, "Could not store object file for '{}' in cache: {}", job.module_name, ec.message());
+        }
+    }
+    if (use_cache && !jobs.empty())
+        trim_cache(cache_dir, MaxCachedObjects);
+    if (result.is_error())
+        return result;
     if (!config.cmdline_flag<bool>("keep-c-file")) {
         for (auto const& file : output_files)
             unlink(file.c_str());
@@ -839,8 +1277,13 @@ ProcessResult& transpile_to_c(ProcessResult& result, Config const& config)
         std::vector<std::string> ld_args = { "-o", config.main(), "-loblcrt", format("-L{}/lib", obl_dir) };
         for (auto& m : modules)
             ld_args.push_back(m);
+        ld_args.push_back("-lpthread");
 
-        if (auto code = execute(linker, ld_args); code.is_error() || (code.value() != 0)) {
+        stopwatch.reset();
+        auto code = execute(linker, ld_args);
+        stats.add_process("link", "", linker, stopwatch, code.is_error() ? -1 : code.value());
+        stats.add_phase("link", stopwatch);
+        if (code.is_error() || (code.value() != 0)) {
             if (code.is_error()) {
                 result.error(SyntaxError { "Linking failed: {}", code.error() });
             } else {
@@ -848,16 +1291,21 @@ ProcessResult& transpile_to_c(ProcessResult& result, Config const& config)
             }
             return result;
         }
-        if (config.run) {
-            auto run_cmd = format("./{}", config.main());
-            auto exit_code = execute(run_cmd);
-            if (exit_code.is_error()) {
-                result.error(SyntaxError { "Execution failed: {}", exit_code.error() });
-                return result;
-            }
-            result = std::make_shared<BoundIntLiteral>(Span {}, (long) exit_code.value());
-        }
+        if (config.run)
+            return run_executable(result, config);
+    }
+    return result;
+}
+
+ProcessResult& run_executable(ProcessResult& result, Config const& config)
+{
+    auto run_cmd = format("./{}", config.main());
+    auto exit_code = execute(run_cmd);
+    if (exit_code.is_error()) {
+        result.error(SyntaxError { "Execution failed: {}", exit_code.error() });
+        return result;
     }
+    result = std::make_shared<BoundIntLiteral>(Span {}, (long) exit_code.value());
     return result;
 }
 
@@ -6,11 +6,16 @@
 
 #pragma once
 
+#include <filesystem>
+#include <vector>
+
 #include <obelix/Config.h>
 #include <obelix/Processor.h>
 
 namespace Obelix {
 
 ProcessResult& transpile_to_c(ProcessResult& result, Config const& config);
+ProcessResult& run_executable(ProcessResult& result, Config const& config);
+ProcessResult& compile_c_in_process(ProcessResult& result, Config const& config, std::vector<std::filesystem::path> const& c_files);
 
 }
@@ -36,32 +36,33 @@ ErrorOr<void, SyntaxError> flush(CTranspilerContext& ctx)
     });
 }
 
-void writeln(CTranspilerContext& ctx, std::string const& text)
+static COutputFile& output(CTranspilerContext& ctx)
 {
-    ctx.call_on_root([&text](CTranspilerContext& ctx) -> void {
-        ctx().writeln(text);
-    });
+    auto& data = ctx();
+    if (data.output == nullptr)
+        data.output = &ctx.root_data().current_file;
+    assert(*data.output);
+    return **data.output;
 }
 
-void write(CTranspilerContext& ctx, std::string const& text)
+void writeln(CTranspilerContext& ctx, std::string_view text)
 {
-    ctx.call_on_root([&text](CTranspilerContext& ctx) -> void {
-        ctx().write(text);
-    });
+    output(ctx).writeln(text);
+}
+
+void write(CTranspilerContext& ctx, std::string_view text)
+{
+    output(ctx).write(text);
 }
 
 void indent(CTranspilerContext& ctx)
 {
-    ctx.call_on_root([](CTranspilerContext& ctx) -> void {
-        ctx().indent();
-    });
+    output(ctx).indent();
 }
 
 void dedent(CTranspilerContext& ctx)
 {
-    ctx.call_on_root([](CTranspilerContext& ctx) -> void {
-        ctx().dedent();
-    });
+    output(ctx).dedent();
 }
 
 std::string const& exit_label(CTranspilerContext const& ctx)
@@ -12,12 +12,14 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include <config.h>
 #include <core/Logging.h>
 #include <core/Process.h>
 #include <obelix/BoundSyntaxNode.h>
 #include <obelix/Context.h>
+#include <obelix/Hash.h>
 #include <obelix/Processor.h>
 #include <obelix/Syntax.h>
 
@@ -25,6 +27,10 @@ namespace Obelix {
 
 extern_logging_category(c_transpiler);
 
+// Append-only writer for a generated C file. Text is indented as it is
+// appended and goes out to .obelix/<name> in chunks, so a module is never
+// held in memory in its entirety. The hash of everything written is kept
+// up to date as the chunks go out, for the object cache.
 class COutputFile {
 public:
     COutputFile(std::string name)
@@ -35,70 +41,102 @@ public:
 
     [[nodiscard]] std::string const& name() const { return m_name; }
     [[nodiscard]] std::filesystem::path const& path() const { return m_path; }
+    [[nodiscard]] std::string content_hash() const { return m_hash.to_string(); }
 
-    ErrorOr<void, SyntaxError> flush()
+    ErrorOr<void, SyntaxError> open()
     {
-        if (m_flushed)
-            return {};
         auto c_file = ".obelix/" + name();
-        std::fstream s(c_file, std::fstream::out);
-        if (!s.is_open())
+        m_stream.open(c_file, std::ofstream::out | std::ofstream::trunc);
+        if (!m_stream.is_open())
             return SyntaxError { ErrorCode::IOError, format("Could not open transpiled file {}", c_file) };
-        s << m_text;
-        if (s.fail() || s.bad())
-            return SyntaxError { ErrorCode::IOError, format("Could not write transpiled file {}", c_file) };
-        m_flushed = true;
+        m_buffer.reserve(BufferSize);
         return {};
     }
 
-    void write(std::string const& text)
+    ErrorOr<void, SyntaxError> flush()
+    {
+        if (!m_stream.is_open())
+            return {};
+        drain();
+        m_stream.close();
+        if (m_stream.fail())
+            return SyntaxError { ErrorCode::IOError, format("Could not write transpiled file .obelix/{}", name()) };
+        return {};
+    }
+
+    void write(std::string_view text)
     {
         if (text.empty())
             return;
-        auto t = text;
-        int trailing_newlines { 0 };
-        while (!t.empty() && t.ends_with("\n")) {
-            trailing_newlines++;
-            t = t.substr(0, t.length() - 1);
-        }
-        t = join(split(t, '\n'), "\n" + m_indent);
-        if (m_text.ends_with("\n"))
-            m_text.append(m_indent);
-        m_text.append(t);
-        for (auto ix = 0; ix < trailing_newlines; ++ix)
-            m_text += "\n";
-        m_flushed = false;
+        append(text, 0);
     }
 
-    void writeln(std::string const& text)
+    void writeln(std::string_view text)
     {
-        write(text + "\n");
+        append(text, 1);
     }
 
     void indent()
     {
-        m_indent += "  ";
+        m_indent += 2;
     }
 
     void dedent()
     {
-        if (m_indent.length() > 0)
-            m_indent = m_indent.substr(0, m_indent.length() - 2);
+        if (m_indent > 0)
+            m_indent -= 2;
     }
 
     [[nodiscard]] std::string to_string() const
     {
         std::string ret = name() + "\n\n";
-        ret += m_text;
+        std::ifstream s(".obelix/" + name());
+        ret.append(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
         return ret;
     }
 
 private:
+    constexpr static size_t BufferSize = 64 * 1024;
+
+    // Appends text followed by extra_newlines newlines. The indentation of a
+    // line is written when the first text on it is appended, so an indent()
+    // or dedent() following a writeln() applies to the next line.
+    void append(std::string_view text, size_t extra_newlines)
+    {
+        auto body_length = text.length();
+        while (body_length > 0 && text[body_length - 1] == '\n')
+            --body_length;
+        auto trailing_newlines = text.length() - body_length + extra_newlines;
+        auto body = text.substr(0, body_length);
+
+        if (m_at_line_start)
+            m_buffer.append(m_indent, ' ');
+        for (auto nl = body.find('\n'); nl != std::string_view::npos; nl = body.find('\n')) {
+            m_buffer.append(body.substr(0, nl + 1));
+            m_buffer.append(m_indent, ' ');
+            body.remove_prefix(nl + 1);
+        }
+        m_buffer.append(body);
+        m_buffer.append(trailing_newlines, '\n');
+        m_at_line_start = trailing_newlines > 0;
+        if (m_buffer.length() >= BufferSize)
+            drain();
+    }
+
+    void drain()
+    {
+        m_hash.update(m_buffer);
+        m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.length()));
+        m_buffer.clear();
+    }
+
     std::string m_name;
     std::filesystem::path m_path;
-    std::string m_text;
-    std::string m_indent;
-    bool m_flushed { false };
+    std::ofstream m_stream;
+    std::string m_buffer;
+    ContentHash m_hash;
+    size_t m_indent { 0 };
+    bool m_at_line_start { false };
 };
 
 class CTranspilerContextPayload {
@@ -121,7 +159,7 @@ public:
         }
         header = std::make_shared<COutputFile>(format("{}.h", main_module));
         current_file = header;
-        return {};
+        return current_file->open();
     }
 
     ErrorOr<void, SyntaxError> open_output_file(std::string name)
@@ -132,7 +170,7 @@ public:
         }
         modules.emplace(name, std::make_shared<COutputFile>(name));
         current_file = modules.at(name);
-        return {};
+        return current_file->open();
     }
 
     std::vector<COutputFile const*> files()
@@ -154,34 +192,21 @@ public:
         return {};
     }
 
-    void writeln(std::string const& text)
-    {
-        assert(current_file);
-        current_file->writeln(text);
-    }
-
-    void write(std::string const& text)
-    {
-        assert(current_file);
-        current_file->write(text);
-    }
-
-    void indent()
-    {
-        assert(current_file);
-        current_file->indent();
-    }
-
-    void dedent()
-    {
-        assert(current_file);
-        current_file->dedent();
-    }
-
     std::shared_ptr<COutputFile> header;
     std::map<std::string, std::shared_ptr<COutputFile>> modules;
     std::shared_ptr<COutputFile> current_file;
     std::string exit_label;
+
+    // Points at current_file in the root context. Looked up the first time
+    // a context writes, so that writes don't have to walk up to the root.
+    std::shared_ptr<COutputFile>* output { nullptr };
+
+    // Set in the context of the outermost block of a function.
+    pBoundFunctionDecl function { nullptr };
+
+    // The variable read by the statement being transpiled whose value is
+    // moved out instead of copied, because it isn't used anymore after it.
+    pBoundVariable moved_variable { nullptr };
 };
 
 using CTranspilerContext = Context<std::shared_ptr<SyntaxNode>, CTranspilerContextPayload>;
@@ -190,8 +215,8 @@ ErrorOr<void, SyntaxError> open_header(CTranspilerContext&, std::string);
 ErrorOr<void, SyntaxError> open_output_file(CTranspilerContext&, std::string);
 std::vector<COutputFile const*> files(CTranspilerContext&);
 ErrorOr<void, SyntaxError> flush(CTranspilerContext&);
-void writeln(CTranspilerContext&, std::string const&);
-void write(CTranspilerContext&, std::string const&);
+void writeln(CTranspilerContext&, std::string_view);
+void write(CTranspilerContext&, std::string_view);
 void indent(CTranspilerContext&);
 void dedent(CTranspilerContext&);
 std::string const& exit_label(CTranspilerContext const&);
@@ -12,6 +12,7 @@ namespace Obelix {
 extern_logging_category(c_transpiler);
 
 static std::array<CTranspilerFunctionType, IntrinsicType::count> s_intrinsics = {};
+static std::array<std::string, IntrinsicType::count> s_expressions = {};
 
 bool register_c_transpiler_intrinsic(IntrinsicType type, CTranspilerFunctionType intrinsic)
 {
@@ -25,11 +26,31 @@ CTranspilerFunctionType const& get_c_transpiler_intrinsic(IntrinsicType type)
     return s_intrinsics[type];
 }
 
+bool register_c_transpiler_expression(IntrinsicType type, std::string expression)
+{
+    s_expressions[type] = std::move(expression);
+    return true;
+}
+
+std::string const& get_c_transpiler_expression(IntrinsicType type)
+{
+    assert(type > IntrinsicType::NotIntrinsic && type < IntrinsicType::count);
+    return s_expressions[type];
+}
+
 #define INTRINSIC(intrinsic)                                                                                                 \
     ErrorOr<void, SyntaxError> c_transpiler_intrinsic_##intrinsic(CTranspilerContext&, ObjectTypes const&);                  \
     auto s_c_transpiler_##intrinsic##_decl = register_c_transpiler_intrinsic(intrinsic, c_transpiler_intrinsic_##intrinsic); \
     ErrorOr<void, SyntaxError> c_transpiler_intrinsic_##intrinsic(CTranspilerContext& ctx, ObjectTypes const& types)
 
+#define EXPRESSION_INTRINSIC(intrinsic, expression)                                                                          \
+    auto s_c_transpiler_##intrinsic##_expression = register_c_transpiler_expression(intrinsic, expression);                  \
+    INTRINSIC(intrinsic)                                                                                                     \
+    {                                                                                                                        \
+        write(ctx, expression);                                                                                              \
+        return {};                                                                                                           \
+    }
+
 #define INTRINSIC_ALIAS(intrinsic, alias) \
     auto s_c_transpiler_##intrinsic##_decl = register_c_transpiler_intrinsic(intrinsic, c_transpiler_intrinsic_##alias);
 
@@ -71,21 +92,19 @@ INTRINSIC(eputs)
 
 INTRINSIC(fputs)
 {
-    writeln(ctx, "write($arg0,$arg2,$arg1);");
+    writeln(ctx, "$fwrite($arg0,$arg2,$arg1);");
     return {};
 }
 
 INTRINSIC(int_to_string)
 {
-    fatal("Not implemented");
+    write(ctx, "to_string_s($arg0, 10)");
+    return {};
 }
 
 INTRINSIC(putchar)
 {
-    writeln(ctx,
-R"(
-uint8_t ch = (uint8_t) $arg0;
-write(1,&ch,1);)");
+    writeln(ctx, "$putchar($arg0);");
     return {};
 }
 
@@ -101,107 +120,23 @@ INTRINSIC(dereference)
     return {};
 }
 
-INTRINSIC(add_int_int)
-{
-    write(ctx, "$arg0 + $arg1");
-    return {};
-}
-
-INTRINSIC(subtract_int_int)
-{
-    write(ctx, "$arg0 - $arg1");
-    return {};
-}
-
-INTRINSIC(multiply_int_int)
-{
-    write(ctx, "$arg0 * $arg1");
-    return {};
-}
-
-INTRINSIC(divide_int_int)
-{
-    write(ctx, "$arg0 / $arg1");
-    return {};
-}
-
-INTRINSIC(equals_int_int)
-{
-    write(ctx, "$arg0 == $arg1");
-    return {};
-}
-
-INTRINSIC(greater_int_int)
-{
-    write(ctx, "$arg0 > $arg1");
-    return {};
-}
-
-INTRINSIC(less_int_int)
-{
-    write(ctx, "$arg0 < $arg1");
-    return {};
-}
-
-INTRINSIC(negate_s64)
-{
-    write(ctx, "-$arg0");
-    return {};
-}
-
-INTRINSIC(negate_s32)
-{
-    write(ctx, "-$arg0");
-    return {};
-}
-
-INTRINSIC(negate_s16)
-{
-    write(ctx, "-$arg0");
-    return {};
-}
-
-INTRINSIC(negate_s8)
-{
-    write(ctx, "-$arg0");
-    return {};
-}
-
-INTRINSIC(invert_int)
-{
-    write(ctx, "~$arg0");
-    return {};
-}
-
-INTRINSIC(invert_bool)
-{
-    write(ctx, "!$arg0");
-    return {};
-}
-
-INTRINSIC(and_bool_bool)
-{
-    write(ctx, "$arg0 && $arg1");
-    return {};
-}
-
-INTRINSIC(or_bool_bool)
-{
-    write(ctx, "$arg0 || $arg1");
-    return {};
-}
-
-INTRINSIC(xor_bool_bool)
-{
-    write(ctx, "$arg0 ^ $arg1");
-    return {};
-}
-
-INTRINSIC(equals_bool_bool)
-{
-    write(ctx, "$arg0 == $arg1");
-    return {};
-}
+EXPRESSION_INTRINSIC(add_int_int, "$arg0 + $arg1")
+EXPRESSION_INTRINSIC(subtract_int_int, "$arg0 - $arg1")
+EXPRESSION_INTRINSIC(multiply_int_int, "$arg0 * $arg1")
+EXPRESSION_INTRINSIC(divide_int_int, "$arg0 / $arg1")
+EXPRESSION_INTRINSIC(equals_int_int, "$arg0 == $arg1")
+EXPRESSION_INTRINSIC(greater_int_int, "$arg0 > $arg1")
+EXPRESSION_INTRINSIC(less_int_int, "$arg0 < $arg1")
+EXPRESSION_INTRINSIC(negate_s64, "-$arg0")
+EXPRESSION_INTRINSIC(negate_s32, "-$arg0")
+EXPRESSION_INTRINSIC(negate_s16, "-$arg0")
+EXPRESSION_INTRINSIC(negate_s8, "-$arg0")
+EXPRESSION_INTRINSIC(invert_int, "~$arg0")
+EXPRESSION_INTRINSIC(invert_bool, "!$arg0")
+EXPRESSION_INTRINSIC(and_bool_bool, "$arg0 && $arg1")
+EXPRESSION_INTRINSIC(or_bool_bool, "$arg0 || $arg1")
+EXPRESSION_INTRINSIC(xor_bool_bool, "$arg0 ^ $arg1")
+EXPRESSION_INTRINSIC(equals_bool_bool, "$arg0 == $arg1")
 
 INTRINSIC(add_str_str)
 {
@@ -223,7 +158,7 @@ INTRINSIC(less_str_str)
 
 INTRINSIC(equals_str_str)
 {
-    write(ctx, "str_compare($arg0, $arg1) == 0");
+    write(ctx, "str_equals($arg0, $arg1)");
     return {};
 }
 
@@ -236,9 +171,7 @@ INTRINSIC(multiply_str_int)
 INTRINSIC(enum_text_value)
 {
     auto enum_type = types[0];
-    writeln(ctx, format(
-R"($enum_value v = $get_enum_value($_{}_values, $arg0);
-str_view_for(v.text);)", enum_type->name()));
+    write(ctx, format("$enum_text(&$_{}_table, $arg0)", enum_type->name()));
     return {};
 }
 
@@ -20,4 +20,10 @@ using CTranspilerFunctionType = std::function<ErrorOr<void, SyntaxError>(CTransp
 bool register_c_transpiler_intrinsic(IntrinsicType, CTranspilerFunctionType);
 CTranspilerFunctionType const& get_c_transpiler_intrinsic(IntrinsicType);
 
+// Pure intrinsics, without side effects, register the C expression they
+// translate to. Every $argN placeholder occurs once in the expression.
+// Other intrinsics return an empty string.
+bool register_c_transpiler_expression(IntrinsicType, std::string);
+std::string const& get_c_transpiler_expression(IntrinsicType);
+
 }
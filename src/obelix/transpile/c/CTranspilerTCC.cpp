@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+#include <config.h>
+#include <core/Logging.h>
+#include <obelix/BoundSyntaxNode.h>
+#include <obelix/Stats.h>
+#include <obelix/transpile/c/CTranspiler.h>
+
+#if OBELIX_LIBTCC
+#include <libtcc.h>
+#endif
+
+namespace Obelix {
+
+extern_logging_category(c_transpiler);
+
+#if OBELIX_LIBTCC
+
+// Compiles the generated C files with libtcc, without starting any external
+// processes. With --run the program is relocated in memory and run from
+// there. Otherwise, tcc writes the executable. tcc optimizes far less than
+// cc -O3, so this is meant for quick edit-and-run cycles and the test suite,
+// not for release builds.
+//
+// The program is linked against oblcrt_notls, a build of the runtime that
+// doesn't use thread-local storage. tcc's linker doesn't handle the TLS
+// relocations in objects built by gcc or clang.
+ProcessResult& compile_c_in_process(ProcessResult& result, Config const& config, std::vector<std::filesystem::path> const& c_files)
+{
+    auto obl_dir = config.obelix_directory();
+    std::string errors;
+    auto state = tcc_new();
+    if (state == nullptr) {
+        result.error(SyntaxError { "Could not initialize libtcc" });
+        return result;
+    }
+    tcc_set_error_func(state, &errors, [](void* opaque, char const* msg) {
+        auto errors = static_cast<std::string*>(opaque);
+        *errors += msg;
+        *errors += "\n";
+    });
+    tcc_set_output_type(state, (config.run) ? TCC_OUTPUT_MEMORY : TCC_OUTPUT_EXE);
+    tcc_add_include_path(state, format("{}/include", obl_dir).c_str());
+    tcc_add_library_path(state, format("{}/lib", obl_dir).c_str());
+
+    auto& stats = CompilerStats::get_stats();
+    Stopwatch stopwatch;
+    auto ok = true;
+    for (auto const& c_file : c_files) {
+        debug(c_transpiler, "Compiling '{}' in process", c_file.string());
+        if (tcc_add_file(state, c_file.c_str()) < 0) {
+            ok = false;
+            break;
+        }
+    }
+    ok = ok && tcc_add_library(state, "oblcrt_notls") >= 0 && tcc_add_library(state, "pthread") >= 0;
+    if (ok && !config.run)
+        ok = tcc_output_file(state, config.main().c_str()) >= 0;
+    if (ok && config.run) {
+#ifdef TCC_RELOCATE_AUTO
+        ok = tcc_relocate(state, TCC_RELOCATE_AUTO) >= 0;
+#else
+        ok = tcc_relocate(state) >= 0;
+#endif
+    }
+    stats.add_phase("tcc", stopwatch);
+    if (!ok) {
+        std::cerr << errors;
+        result.error(SyntaxError { "In-process compilation of '{}' failed", config.main() });
+        tcc_delete(state);
+        return result;
+    }
+    if (!config.run) {
+        tcc_delete(state);
+        return result;
+    }
+
+    // The program runs in a child process, so that its exit() and its runtime
+    // errors don't take the compiler down with it:
+    auto main_func = reinterpret_cast<int (*)(int, char**)>(tcc_get_symbol(state, "main"));
+    auto flush_func = reinterpret_cast<void (*)()>(tcc_get_symbol(state, "flush"));
+    if (main_func == nullptr || flush_func == nullptr) {
+        result.error(SyntaxError { "No main() function found in '{}'", config.main() });
+        tcc_delete(state);
+        return result;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    auto pid = fork();
+    if (pid == 0) {
+        std::string program_name = config.main();
+        char* argv[] = { program_name.data(), nullptr };
+        auto exit_code = main_func(1, argv);
+        // The runtime's main() leaves flushing to an atexit hook. _exit()
+        // skips that, but also the compiler's own static destructors and
+        // atexit handlers, which have no business running in the child:
+        flush_func();
+        _exit(exit_code);
+    }
+    tcc_delete(state);
+    if (pid < 0) {
+        result.error(SyntaxError { "Execution failed: could not fork" });
+        return result;
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        result.error(SyntaxError { "Execution failed: could not wait for the program to finish" });
+        return result;
+    }
+    // Like a shell, report a program killed by a signal with exit code
+    // 128 plus the signal number:
+    auto exit_code = -1;
+    if (WIFEXITED(status)) {
+        exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        std::cerr << format("'{}' was terminated by signal {} ({})", config.main(), WTERMSIG(status), strsignal(WTERMSIG(status))) << std::endl;
+        exit_code = 128 + WTERMSIG(status);
+    }
+    result = std::make_shared<BoundIntLiteral>(Span {}, (long) exit_code);
+    return result;
+}
+
+#else
+
+ProcessResult& compile_c_in_process(ProcessResult& result, Config const&, std::vector<std::filesystem::path> const&)
+{
+    result.error(SyntaxError { "--in-process-cc is not available: this compiler was built without libtcc" });
+    return result;
+}
+
+#endif
+
+}
@@ -48,7 +48,7 @@ size_t hash(TemplateArgumentValue const& arg)
     if (std::holds_alternative<std::string>(arg))
         return std::hash<std::string> {}(std::get<std::string>(arg));
     if (std::holds_alternative<std::shared_ptr<ObjectType>>(arg))
-        return std::hash<std::shared_ptr<ObjectType>> {}(std::get<std::shared_ptr<ObjectType>>(arg));
+        return std::get<std::shared_ptr<ObjectType>>(arg)->hash();
     if (std::holds_alternative<bool>(arg))
         return std::hash<bool> {}(std::get<bool>(arg));
     assert(std::holds_alternative<NVP>(arg));
@@ -208,6 +208,11 @@ TemplateArgumentValues const& TemplateArgument::as_values() const
 size_t TemplateArgument::hash() const
 {
     size_t ret = std::hash<int> {}(static_cast<int>(parameter_type));
+    // The values of an enum change when it is extended, and the hash of a
+    // registered type must not change, so name-value arguments don't
+    // contribute to it:
+    if (parameter_type == TemplateParameterType::NameValue)
+        return ret;
     for (auto const& arg : value) {
         ret ^= Obelix::hash(arg);
     }
@@ -65,9 +65,10 @@ bool FieldDef::operator==(Obelix::FieldDef const& other) const
     return name == other.name && *type == *other.type;
 }
 
+uint32_t ObjectType::s_any_generation { 1 };
 std::unordered_map<PrimitiveType, pObjectType> ObjectType::s_types_by_id {};
 std::unordered_map<std::string, pObjectType> ObjectType::s_types_by_name {};
-std::vector<pObjectType> ObjectType::s_template_specializations {};
+std::unordered_multimap<size_t, pObjectType> ObjectType::s_template_specializations {};
 
 [[maybe_unused]] pObjectType s_self;
 [[maybe_unused]] pObjectType s_argument;
@@ -360,6 +361,7 @@ pMethodDescription ObjectType::add_method(MethodDescription const& md)
     pMethodDescription new_md = std::make_shared<MethodDescription>(md, shared_from_this());
     new_md->set_method_of(shared_from_this());
     m_methods.push_back(std::move(new_md));
+    invalidate_dispatch_tables();
     return m_methods.back();
 }
 
@@ -377,7 +379,9 @@ ObjectType::ObjectType(PrimitiveType type, std::string name) noexcept
 
 void ObjectType::will_be_a(pObjectType type)
 {
+    type->m_subtypes.push_back(weak_from_this());
     m_is_a.push_back(std::move(type));
+    invalidate_dispatch_tables();
 }
 
 void ObjectType::has_template_parameter(TemplateParameter const& parameter)
@@ -500,6 +504,33 @@ bool ObjectType::operator==(ObjectType const& other) const
     return template_arguments() == other.template_arguments();
 }
 
+static size_t specialization_hash(ObjectType const& base_type, TemplateArguments const& template_args)
+{
+    auto ret = base_type.hash();
+    for (auto const& [name, arg] : template_args) {
+        ret = ret * 31 + (std::hash<std::string> {}(name) ^ arg.hash());
+    }
+    return ret;
+}
+
+/*
+ * hash - hash consistent with operator==. Only uses the properties compared
+ * by operator== that don't change after a type is registered; in particular,
+ * the name and size of a type and the values of an enum are not used.
+ */
+size_t ObjectType::hash() const
+{
+    auto ret = std::hash<int> {}(static_cast<int>(type()));
+    if (specializes_template() != nullptr)
+        return ret ^ (specialization_hash(*specializes_template(), template_arguments()) << 1);
+    if (type() == PrimitiveType::Struct) {
+        for (auto const& field : fields()) {
+            ret = ret * 31 + std::hash<std::string> {}(field.name);
+        }
+    }
+    return ret;
+}
+
 /*
  * is_assignable_to - is a value of this type assignable to the other type.
  *  - non-integers: types must be the same.
@@ -726,27 +757,33 @@ bool ObjectType::is_compatible(pMethodDescription const& mth, ObjectTypes const&
     return (ix == mth->parameters().size());
 }
 
-pObjectType ObjectType::return_type_of(std::string_view method_name, ObjectTypes const& argument_types) const
+/*
+ * The dispatch table is built the first time a method or operator of a type
+ * is looked up. Adding a method or a super type to a type drops its table and
+ * those of all types that inherit from it or specialize it. Every type
+ * inherits from 'any', so changes to 'any' are tracked with a generation
+ * counter instead of by visiting every type.
+ */
+void ObjectType::invalidate_dispatch_tables()
 {
-    auto check_methods_of = [&method_name, &argument_types, this](ObjectType const* type) -> pObjectType {
-        for (auto& mth : type->m_methods) {
-            if (mth->is_operator())
-                continue;
-            if (mth->name() != method_name)
-                continue;
-            if (!is_compatible(mth, argument_types))
-                continue;
-            if (*(mth->return_type()) == *s_self)
-                return ObjectType::get(this);
-            if (*(mth->return_type()) == *s_argument)
-                return argument_types[0];
-            return mth->return_type();
-        }
-        return s_unknown;
-    };
+    if (this == s_any.get()) {
+        ++s_any_generation;
+        return;
+    }
+    m_dispatch_table.valid = false;
+    for (auto const& subtype : m_subtypes) {
+        if (auto type = subtype.lock(); type != nullptr)
+            type->invalidate_dispatch_tables();
+    }
+}
+
+ObjectType::DispatchTable const& ObjectType::dispatch_table() const
+{
+    if (m_dispatch_table.valid && m_dispatch_table.any_generation == s_any_generation)
+        return m_dispatch_table;
 
-    auto self = get(this);
-    ObjectTypes types { s_any, self };
+    m_dispatch_table = DispatchTable { true, s_any_generation };
+    cObjectTypes types { s_any, shared_from_this() };
     while (!types.empty()) {
         auto type = types.back();
         types.pop_back();
@@ -755,49 +792,66 @@ pObjectType ObjectType::return_type_of(std::string_view method_name, ObjectTypes
         }
         if (type->is_template_specialization())
             types.push_back(type->specializes_template());
-        if (auto ret = check_methods_of(type.get()); *ret != *s_unknown)
-            return ret;
+        for (auto const& mth : type->m_methods) {
+            if (mth->is_operator())
+                m_dispatch_table.operators[mth->op()].push_back(mth);
+            else
+                m_dispatch_table.methods[mth->name()].push_back(mth);
+        }
+    }
+    return m_dispatch_table;
+}
+
+MethodDescriptions const& ObjectType::operator_candidates(Operator op) const
+{
+    static MethodDescriptions s_none {};
+    auto const& operators = dispatch_table().operators;
+    if (auto it = operators.find(op); it != operators.end())
+        return it->second;
+    return s_none;
+}
+
+MethodDescriptions const& ObjectType::method_candidates(std::string const& name) const
+{
+    static MethodDescriptions s_none {};
+    auto const& methods = dispatch_table().methods;
+    if (auto it = methods.find(name); it != methods.end())
+        return it->second;
+    return s_none;
+}
+
+pObjectType ObjectType::return_type_of(std::string_view method_name, ObjectTypes const& argument_types) const
+{
+    for (auto const& mth : method_candidates(std::string(method_name))) {
+        if (!is_compatible(mth, argument_types))
+            continue;
+        if (*(mth->return_type()) == *s_self)
+            return ObjectType::get(this);
+        if (*(mth->return_type()) == *s_argument)
+            return argument_types[0];
+        return mth->return_type();
     }
     return {};
 }
 
 pObjectType ObjectType::return_type_of(Operator op, ObjectTypes const& argument_types) const
 {
-    auto check_operators_of = [&op, &argument_types, this](ObjectType const* type) -> pObjectType {
-        for (auto& mth : type->m_methods) {
-            if (!mth->is_operator())
-                continue;
-            if (mth->op() != op)
-                continue;
-            if (!is_compatible(mth, argument_types))
-                continue;
-            if (mth->return_type()->type() == PrimitiveType::Self)
-                return ObjectType::get(this);
-            if (mth->return_type()->type() == PrimitiveType::Argument)
-                return argument_types[0];
-            return mth->return_type();
+    if (type_logger.enabled()) {
+        std::string s;
+        for (auto const& arg : argument_types) {
+            s += ",";
+            s += arg->to_string();
         }
-        return nullptr;
-    };
-
-    std::string s;
-    for (auto const& arg : argument_types) {
-        s += ",";
-        s += arg->to_string();
+        debug(type, "{}::return_type_of({}{})", this->to_string(), op, s);
     }
-    debug(type, "{}::return_type_of({}{})", this->to_string(), op, s);
-    auto self = get(this);
-    ObjectTypes types { s_any, self };
-    while (!types.empty()) {
-        auto type = types.back();
-        types.pop_back();
-        for (auto& is_a : type->m_is_a) {
-            types.push_back(is_a);
-        }
-        if (type->is_template_specialization())
-            types.push_back(type->specializes_template());
-        if (auto ret = check_operators_of(type.get()); ret != nullptr)
-            return ret;
+    for (auto const& mth : operator_candidates(op)) {
+        if (!is_compatible(mth, argument_types))
+            continue;
+        if (mth->return_type()->type() == PrimitiveType::Self)
+            return ObjectType::get(this);
+        if (mth->return_type()->type() == PrimitiveType::Argument)
+            return argument_types[0];
+        return mth->return_type();
     }
     return nullptr;
 }
@@ -826,114 +880,54 @@ MethodDescriptions ObjectType::methods(bool deep) const
 
 pMethodDescription ObjectType::get_method(Operator op) const
 {
-    auto check_operators_of = [&op, this](ObjectType const* type) -> pMethodDescription {
-        for (auto& mth : type->m_methods) {
-            if (!mth->is_operator())
-                continue;
-            if (mth->op() != op)
-                continue;
-            if (*(mth->return_type()) == *s_self) {
-                auto ret = std::make_shared<MethodDescription>(*mth);
-                ret->set_return_type(ObjectType::get(this));
-                return ret;
-            }
-            return mth;
-        }
-        return nullptr;
-    };
-
-    cObjectTypes types { s_any, shared_from_this() };
-    while (!types.empty()) {
-        auto type = types.back();
-        types.pop_back();
-        for (auto& is_a : type->m_is_a) {
-            types.push_back(is_a);
-        }
-        if (type->is_template_specialization())
-            types.push_back(type->specializes_template());
-        if (auto ret = check_operators_of(type.get()); ret != nullptr)
-            return ret;
+    auto const& candidates = operator_candidates(op);
+    if (candidates.empty())
+        return {};
+    auto const& mth = candidates.front();
+    if (*(mth->return_type()) == *s_self) {
+        auto ret = std::make_shared<MethodDescription>(*mth);
+        ret->set_return_type(ObjectType::get(this));
+        return ret;
     }
-    return {};
+    return mth;
 }
 
 pMethodDescription ObjectType::get_method(Operator op, ObjectTypes const& argument_types) const
 {
-    auto check_operators_of = [&op, &argument_types, this](ObjectType const* type) -> pMethodDescription {
-        for (auto& mth : type->m_methods) {
-            if (!mth->is_operator())
-                continue;
-            if (mth->op() != op)
-                continue;
-            if (!mth->is_compatible(argument_types))
-                continue;
-            if (*(mth->return_type()) == *s_self) {
-                auto ret = std::make_shared<MethodDescription>(*mth);
-                ret->set_return_type(ObjectType::get(this));
-                return ret;
-            }
-            if (*(mth->return_type()) == *s_argument) {
-                auto ret = mth;
-                ret->set_return_type(argument_types[0]);
-                return ret;
-            }
-            return mth;
-        }
-        return nullptr;
-    };
-
-    auto self = get(this);
-    ObjectTypes types { s_any, self };
-    while (!types.empty()) {
-        auto type = types.back();
-        types.pop_back();
-        for (auto& is_a : type->m_is_a) {
-            types.push_back(is_a);
+    for (auto const& mth : operator_candidates(op)) {
+        if (!mth->is_compatible(argument_types))
+            continue;
+        if (*(mth->return_type()) == *s_self) {
+            auto ret = std::make_shared<MethodDescription>(*mth);
+            ret->set_return_type(ObjectType::get(this));
+            return ret;
         }
-        if (type->is_template_specialization())
-            types.push_back(type->specializes_template());
-        if (auto ret = check_operators_of(type.get()); ret != nullptr)
+        if (*(mth->return_type()) == *s_argument) {
+            auto ret = mth;
+            ret->set_return_type(argument_types[0]);
             return ret;
+        }
+        return mth;
     }
     return nullptr;
 }
 
 pMethodDescription ObjectType::get_method(std::string const& name, ObjectTypes const& argument_types) const
 {
-    auto check_methods_of = [&name, &argument_types, this](ObjectType const* type) -> pMethodDescription {
-        for (auto& mth : type->m_methods) {
-            if (mth->is_operator())
-                continue;
-            if (mth->name() != name)
-                continue;
-            if (!is_compatible(mth, argument_types))
-                continue;
-            if (*(mth->return_type()) == *s_self) {
-                auto ret = std::make_shared<MethodDescription>(*mth);
-                ret->set_return_type(ObjectType::get(this));
-                return ret;
-            }
-            if (*(mth->return_type()) == *s_argument) {
-                auto ret = mth;
-                ret->set_return_type(argument_types[0]);
-                return ret;
-            }
-            return mth;
-        }
-        return nullptr;
-    };
-
-    cObjectTypes types { s_any, shared_from_this() };
-    while (!types.empty()) {
-        auto type = types.back();
-        types.pop_back();
-        for (auto& is_a : type->m_is_a) {
-            types.push_back(is_a);
+    for (auto const& mth : method_candidates(name)) {
+        if (!is_compatible(mth, argument_types))
+            continue;
+        if (*(mth->return_type()) == *s_self) {
+            auto ret = std::make_shared<MethodDescription>(*mth);
+            ret->set_return_type(ObjectType::get(this));
+            return ret;
         }
-        if (type->is_template_specialization())
-            types.push_back(type->specializes_template());
-        if (auto ret = check_methods_of(type.get()); ret != nullptr)
+        if (*(mth->return_type()) == *s_argument) {
+            auto ret = mth;
+            ret->set_return_type(argument_types[0]);
             return ret;
+        }
+        return mth;
     }
     return nullptr;
 }
@@ -977,10 +971,10 @@ pObjectType ObjectType::get(ObjectType const* type)
     if (!type->is_template_specialization())
         return get(type->name());
 
-    for (auto& instantiation : s_template_specializations) {
-        if (*type == *instantiation) {
-            return instantiation;
-        }
+    auto [first, last] = s_template_specializations.equal_range(type->hash());
+    for (auto it = first; it != last; ++it) {
+        if (*type == *it->second)
+            return it->second;
     }
     return nullptr;
 }
@@ -1032,7 +1026,11 @@ ErrorOr<pObjectType,SyntaxError> ObjectType::specialize(pObjectType const& base_
         return SyntaxError { ErrorCode::TypeNotParameterized, base_type };
     if (!base_type->is_parameterized())
         return base_type;
-    for (auto& template_specialization : s_template_specializations) {
+    // Same as the hash() of the specialization:
+    auto key = std::hash<int> {}(static_cast<int>(base_type->type())) ^ (specialization_hash(*base_type, template_args) << 1);
+    auto [first, last] = s_template_specializations.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+        auto const& template_specialization = it->second;
         if ((*template_specialization->specializes_template() == *base_type) && (template_specialization->template_arguments() == template_args))
             return template_specialization;
     }
@@ -1040,12 +1038,14 @@ ErrorOr<pObjectType,SyntaxError> ObjectType::specialize(pObjectType const& base_
     auto specialization = register_type(base_type->type(), format("{}_{}", base_type->name(), counter++),
         [&template_args, &base_type](pObjectType const& new_type) {
             new_type->m_specializes_template = base_type;
+            base_type->m_subtypes.push_back(new_type);
             new_type->m_template_arguments = template_args;
             if (base_type->m_stamp) {
                 base_type->m_stamp(new_type);
             }
         });
-    s_template_specializations.push_back(specialization);
+    assert(specialization->hash() == key);
+    s_template_specializations.emplace(key, specialization);
     return specialization;
 }
 
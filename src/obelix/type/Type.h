@@ -448,6 +448,7 @@ public:
     ErrorOr<void,SyntaxError> extend_enum_type(NVPs const&);
 
     bool operator==(ObjectType const&) const;
+    [[nodiscard]] size_t hash() const;
     [[nodiscard]] bool is_assignable_to(pcObjectType const&) const;
     [[nodiscard]] bool is_assignable_to(pObjectType const&) const;
     [[nodiscard]] bool is_assignable_to(ObjectType const&) const;
@@ -504,7 +505,20 @@ public:
     static void dump();
 
 private:
+    // The methods of a type and all its ancestors, indexed by operator and
+    // by name. Candidates are ordered like the type hierarchy is searched.
+    struct DispatchTable {
+        bool valid { false };
+        uint32_t any_generation { 0 };
+        std::unordered_map<Operator, MethodDescriptions> operators {};
+        std::unordered_map<std::string, MethodDescriptions> methods {};
+    };
+
     [[nodiscard]] bool is_compatible(pMethodDescription const&, ObjectTypes const&) const;
+    [[nodiscard]] DispatchTable const& dispatch_table() const;
+    void invalidate_dispatch_tables();
+    [[nodiscard]] MethodDescriptions const& operator_candidates(Operator) const;
+    [[nodiscard]] MethodDescriptions const& method_candidates(std::string const&) const;
     static void register_type_in_caches(pObjectType const&);
 
     PrimitiveType m_type { PrimitiveType::Unknown };
@@ -515,16 +529,19 @@ private:
     MethodDescriptions m_methods {};
     FieldDefs m_fields {};
     std::vector<pObjectType> m_is_a;
+    std::vector<std::weak_ptr<ObjectType>> m_subtypes {};
     TemplateParameters m_template_parameters {};
     std::vector<std::string> m_template_parameters_by_index {};
     pObjectType m_specializes_template { nullptr };
     TemplateArguments m_template_arguments {};
     ObjectTypeBuilder m_stamp {};
     CanCastTo m_can_cast_to {};
+    mutable DispatchTable m_dispatch_table {};
 
+    static uint32_t s_any_generation;
     static std::unordered_map<PrimitiveType, pObjectType> s_types_by_id;
     static std::unordered_map<std::string, pObjectType> s_types_by_name;
-    static std::vector<pObjectType> s_template_specializations;
+    static std::unordered_multimap<size_t, pObjectType> s_template_specializations;
 };
 
 template<typename T>
@@ -11,22 +11,44 @@ cstr    .req x0
 
 ; Work
 ptr     .req x9
-char    .req w10
+mask    .req x10
+shift   .req x11
+
+; The string is scanned 16 bytes at a time, using aligned loads so we never
+; read across a page boundary. NEON has no movemask instruction; narrowing
+; the result of the compare by 4 bits gives a 64 bit mask with a nibble per
+; byte instead.
 
 cstrlen:
     stp     fp,lr,[sp,#-16]!
     mov     fp,sp
 
-    mov     ptr,cstr
+    and     ptr,cstr,#-16                   ; Start at the aligned block containing the first byte
+    ldr     q0,[ptr]
+    cmeq    v0.16b,v0.16b,#0                ; 0xFF for every \0 byte
+    shrn    v0.8b,v0.8h,#4                  ; Narrow to a nibble per byte
+    fmov    mask,d0
+    and     shift,cstr,#15                  ; Ignore the bytes before the start of the string
+    lsl     shift,shift,#2
+    lsr     mask,mask,shift
+    cbz     mask,__cstrlen_loop
+    rbit    mask,mask                       ; The \0 is in the first block. Its index is the number
+    clz     mask,mask                       ; of trailing zeroes divided by 4
+    lsr     x0,mask,#2
+    b       __cstrlen_done
 
 __cstrlen_loop:
-    ldrb    char,[ptr]
-    cmp     char,#0
-    b.eq    __cstrlen_done
-    add     ptr,ptr,#1
-    b       __cstrlen_loop
+    add     ptr,ptr,#16
+    ldr     q0,[ptr]
+    cmeq    v0.16b,v0.16b,#0
+    shrn    v0.8b,v0.8h,#4
+    fmov    mask,d0
+    cbz     mask,__cstrlen_loop
+    rbit    mask,mask
+    clz     mask,mask
+    add     ptr,ptr,mask,lsr #2             ; ptr now points to the \0
+    sub     x0,ptr,cstr
 
 __cstrlen_done:
-    sub     x0,ptr,cstr
     ldp     fp,lr,[sp],#16
     ret                                     ; Return
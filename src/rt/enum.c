@@ -6,12 +6,38 @@
 
 #include <rt/obelix.h>
 
-$enum_value $get_enum_value($enum_value values[], int32_t value)
+$enum_value* $get_enum_value($enum_table* table, int32_t value)
 {
-    for (int ix = 0; values[ix].text != NULL; ix++) {
-        if (values[ix].value == value)
-            return values[ix];
+    switch (table->kind) {
+    case $enum_dense: {
+        int64_t ix = (int64_t) value - table->base;
+        if (ix < 0 || ix >= table->size || table->values[ix].text == NULL)
+            return NULL;
+        return &table->values[ix];
     }
-    $enum_value ret = { 0, NULL };
-    return ret;
+    case $enum_sorted: {
+        uint32_t low = 0;
+        uint32_t high = table->size;
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            if (table->values[mid].value < value)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low < table->size && table->values[low].value == value)
+            return &table->values[low];
+        return NULL;
+    }
+    default:
+        return NULL;
+    }
+}
+
+string $enum_text($enum_table* table, int32_t value)
+{
+    $enum_value* v = $get_enum_value(table, value);
+    if (v == NULL)
+        return str_view_for("");
+    return str_literal(&v->str, v->text);
 }
@@ -65,6 +65,8 @@ bool_errno $close(uint32_t fh)
 u64_errno $read(uint32_t fh, char* buffer, uint64_t bytes)
 {
     u64_errno ret;
+    // Make sure a prompt written before reading is visible.
+    flush();
     ssize_t bytes_read = read(fh, buffer, bytes);
     if ((ret.success = (bytes_read >= 0))) {
         ret.value = bytes_read;
@@ -77,6 +79,7 @@ u64_errno $read(uint32_t fh, char* buffer, uint64_t bytes)
 u64_errno $write(uint32_t fh, char const* buffer, uint64_t bytes)
 {
     u64_errno ret;
+    flush_fd(fh);
     ssize_t bytes_written = write(fh, buffer, bytes);
     if ((ret.success = (bytes_written >= 0))) {
         ret.value = bytes_written;
@@ -85,3 +88,28 @@ u64_errno $write(uint32_t fh, char const* buffer, uint64_t bytes)
     }
     return ret;
 }
+
+bool_errno $truncate(string path, uint64_t length)
+{
+    bool_errno ret;
+    int fh = open(str_data(path), O_WRONLY | O_CREAT, 0644);
+    if ((ret.success = (fh >= 0 && ftruncate(fh, (off_t) length) >= 0))) {
+        ret.value = true;
+    } else {
+        ret.error = _stdlib_errno;
+    }
+    if (fh >= 0)
+        close(fh);
+    return ret;
+}
+
+bool_errno $unlink(string path)
+{
+    bool_errno ret;
+    if ((ret.success = (unlink(str_data(path)) >= 0))) {
+        ret.value = true;
+    } else {
+        ret.error = _stdlib_errno;
+    }
+    return ret;
+}
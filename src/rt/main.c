@@ -10,13 +10,20 @@
 
 extern int $main(int32_t, int8_t**);
 
+static void flush_at_exit()
+{
+    flush();
+}
+
 void $fatal($token token, char const* msg)
 {
+    flush();
     fprintf(stderr, "%s:%d:%d: Runtime error: %s\n", token.file_name, token.line_start, token.column_start, msg);
     exit(-1);
 }
 
 int main(int argc, char** argv)
 {
+    atexit(flush_at_exit);
     return $main((int32_t) argc, (int8_t **) argv);
 }
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "obelix.h"
+
+// FIXME Find a way to not have to specify these structs here.
+typedef struct _string_errno {
+  bool success;
+  union {
+    string value;
+    int error;
+  };
+} string_errno;
+
+// Maps a file and returns a string viewing its contents. String lengths are
+// 32 bits, so files of 4 GiB and up are refused with EFBIG.
+//
+// The mapping is one byte longer than the file, so that the contents are
+// followed by a NUL like those of every other string, and str_data() can be
+// handed to C functions. Bytes in the file's last page beyond its end read
+// as zero. If the file ends exactly at a page boundary, that byte falls in
+// an anonymous page reserved behind the file.
+string_errno $mmap_file(string path)
+{
+    string_errno ret = { .success = false };
+    int fh = open(str_data(path), O_RDONLY);
+    if (fh < 0) {
+        ret.error = _stdlib_errno;
+        return ret;
+    }
+
+    struct stat sb;
+    if (fstat(fh, &sb) < 0) {
+        ret.error = _stdlib_errno;
+    } else if (sb.st_size > UINT32_MAX) {
+        ret.error = EFBIG;
+    } else if (sb.st_size == 0) {
+        ret.success = true;
+        ret.value = str_view_for("");
+    } else {
+        size_t size = (size_t) sb.st_size;
+        char* data = mmap(NULL, size + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) {
+            ret.error = _stdlib_errno;
+        } else if (mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fh, 0) == MAP_FAILED) {
+            ret.error = _stdlib_errno;
+            munmap(data, size + 1);
+        } else {
+            madvise(data, size, MADV_SEQUENTIAL);
+            ret.success = true;
+            ret.value = str_view_mapped(data, (uint32_t) size);
+        }
+    }
+    close(fh);
+    return ret;
+}
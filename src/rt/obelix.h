@@ -15,11 +15,6 @@
 extern int* __error(void);
 #define _stdlib_errno (*__error())
 
-typedef struct _$enum_value {
-  int32_t value;
-  char* text;
-} $enum_value;
-
 typedef struct _$token {
     char const* file_name;
     int line_start;
@@ -32,24 +27,68 @@ typedef struct _$token {
 typedef void* string;
 #endif
 
+/* The value tables of enums. str caches the text as a runtime string. */
+typedef struct _$enum_value {
+  int32_t value;
+  char* text;
+  string str;
+} $enum_value;
+
+/* Dense tables are indexed by value - base, and have entries with a NULL
+   text for values between base and base + size that aren't in the enum.
+   Sorted tables are ordered by value and are searched. */
+typedef enum _$enum_table_kind {
+  $enum_dense,
+  $enum_sorted,
+} $enum_table_kind;
+
+typedef struct _$enum_table {
+  $enum_table_kind kind;
+  int32_t base;
+  uint32_t size;
+  $enum_value* values;
+} $enum_table;
+
+/* Size of a buffer that can hold any integer formatted by str_format_s or
+   str_format_u, in any radix. */
+#define STR_FORMAT_BUFSZ 66
+
 extern void $fatal($token, char const*);
 
-extern $enum_value $get_enum_value($enum_value[], int32_t);
+extern $enum_value* $get_enum_value($enum_table*, int32_t);
+extern string $enum_text($enum_table*, int32_t);
 
 extern string str_view_for(char const*);
+extern string str_view_mapped(char const*, uint32_t);
 extern string str_allocate(char const*);
 extern string str_adopt(char*);
 extern string str_copy(string);
 extern void str_free(string);
 extern string str_concat(string, string);
+extern string str_builder(uint32_t);
+extern string str_append(string, string);
 extern string str_multiply(string, uint32_t);
 extern char * str_data(string);
 extern uint32_t str_length(string);
 extern int str_compare(string, string);
+extern bool str_equals(string, string);
+extern uint32_t str_hash(string);
+extern string str_intern(string);
+extern string str_intern_literal(char const*);
+extern string str_literal(string*, char const*);
+extern int64_t str_find(string, string);
+extern void str_thread_start();
+extern uint64_t cstrlen(char const*);
 extern string to_string_s(int64_t, int);
 extern string to_string_u(uint64_t, int);
+extern uint32_t str_format_s(char*, int64_t, int);
+extern uint32_t str_format_u(char*, uint64_t, int);
 extern void str_inspect_pools();
 
+extern int flush();
+extern int flush_fd(int);
+extern int $fwrite(int, char const*, uint64_t);
+extern int $putchar(uint32_t);
 extern int $fputs(int, string);
 extern int $puts(string);
 extern int $eputs(string);
@@ -4,11 +4,218 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <rt/obelix.h>
 
+// Output to stdout and stderr is collected in a buffer per stream, and
+// written when the buffer fills up, when flush() is called, and when the
+// program exits. In line mode a buffer is also written at the end of every
+// line. The mode is taken from the OBL_BUFFERING environment variable,
+// which can be "none", "line" or "full". If it isn't set, stdout is line
+// buffered when it's a terminal and fully buffered otherwise, and stderr
+// is not buffered.
+//
+// The buffers are shared by all threads, and every access to them is done
+// while holding buffers_lock. The functions with a _locked suffix expect the
+// caller to hold it.
+
+#define OUTPUT_BUFFER_SIZE 65536
+
+typedef enum _output_buffer_mode {
+    BUFFER_UNINITIALIZED = 0,
+    BUFFER_NONE,
+    BUFFER_LINE,
+    BUFFER_FULL,
+} output_buffer_mode;
+
+typedef struct _output_buffer {
+    int fd;
+    output_buffer_mode mode;
+    size_t used;
+    char data[OUTPUT_BUFFER_SIZE];
+} output_buffer;
+
+static output_buffer buffers[] = {
+    { .fd = 1 },
+    { .fd = 2 },
+};
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int _out_write_fd(int fd, char const* ptr, size_t len)
+{
+    size_t written = 0;
+    while (written < len) {
+        ssize_t ret = write(fd, ptr + written, len - written);
+        if (ret < 0) {
+            if (_stdlib_errno == EINTR)
+                continue;
+            return -_stdlib_errno;
+        }
+        written += ret;
+    }
+    return (int) written;
+}
+
+static output_buffer* _out_buffer_locked(int fd)
+{
+    if (fd != 1 && fd != 2)
+        return NULL;
+    output_buffer* buffer = &buffers[fd - 1];
+    if (buffer->mode == BUFFER_UNINITIALIZED) {
+        char const* mode = getenv("OBL_BUFFERING");
+        if (mode && !strcmp(mode, "none")) {
+            buffer->mode = BUFFER_NONE;
+        } else if (mode && !strcmp(mode, "line")) {
+            buffer->mode = BUFFER_LINE;
+        } else if (mode && !strcmp(mode, "full")) {
+            buffer->mode = BUFFER_FULL;
+        } else {
+            buffer->mode = (fd == 2) ? BUFFER_NONE : (isatty(fd) ? BUFFER_LINE : BUFFER_FULL);
+        }
+    }
+    return buffer;
+}
+
+static int _out_flush_locked(output_buffer* buffer)
+{
+    if (buffer->used == 0)
+        return 0;
+    int ret = _out_write_fd(buffer->fd, buffer->data, buffer->used);
+    buffer->used = 0;
+    return ret;
+}
+
+// Makes sure there is room for len bytes in the buffer. Returns a negative
+// errno if the buffer had to be flushed and that failed.
+static int _out_reserve_locked(output_buffer* buffer, size_t len)
+{
+    if (buffer->used + len <= OUTPUT_BUFFER_SIZE)
+        return 0;
+    int ret = _out_flush_locked(buffer);
+    return (ret < 0) ? ret : 0;
+}
+
+// Called after len bytes were added to the buffer.
+static int _out_commit_locked(output_buffer* buffer, size_t len, bool newline)
+{
+    buffer->used += len;
+    if (buffer->mode == BUFFER_NONE || (newline && buffer->mode == BUFFER_LINE)) {
+        int ret = _out_flush_locked(buffer);
+        if (ret < 0)
+            return ret;
+    }
+    return (int) len;
+}
+
+static int _out_write_locked(int fd, char const* ptr, size_t len)
+{
+    output_buffer* buffer = _out_buffer_locked(fd);
+    if (!buffer)
+        return _out_write_fd(fd, ptr, len);
+    if (fd == 2 && buffers[0].used > 0) {
+        // Keep stdout and stderr in order when they end up in the same place.
+        int ret = _out_flush_locked(&buffers[0]);
+        if (ret < 0)
+            return ret;
+    }
+    int ret = _out_reserve_locked(buffer, len);
+    if (ret < 0)
+        return ret;
+    if (len > OUTPUT_BUFFER_SIZE)
+        return _out_write_fd(fd, ptr, len);
+    memcpy(buffer->data + buffer->used, ptr, len);
+    return _out_commit_locked(buffer, len, memchr(ptr, '\n', len) != NULL);
+}
+
+static int _out_write(int fd, char const* ptr, size_t len)
+{
+    if (fd != 1 && fd != 2)
+        return _out_write_fd(fd, ptr, len);
+    pthread_mutex_lock(&buffers_lock);
+    int ret = _out_write_locked(fd, ptr, len);
+    pthread_mutex_unlock(&buffers_lock);
+    return ret;
+}
+
+// Integers are formatted straight into the output buffer.
+static uint32_t _out_format(char* ptr, uint64_t num, bool is_signed, int radix)
+{
+    return (is_signed) ? str_format_s(ptr, (int64_t) num, radix) : str_format_u(ptr, num, radix);
+}
+
+static int _out_write_number_locked(int fd, uint64_t num, bool is_signed, int radix, bool newline)
+{
+    output_buffer* buffer = _out_buffer_locked(fd);
+    if (!buffer || buffer->mode == BUFFER_NONE) {
+        char digits[STR_FORMAT_BUFSZ + 1];
+        uint32_t len = _out_format(digits, num, is_signed, radix);
+        if (newline)
+            digits[len++] = '\n';
+        return _out_write_locked(fd, digits, len);
+    }
+    int ret = _out_reserve_locked(buffer, STR_FORMAT_BUFSZ + 1);
+    if (ret < 0)
+        return ret;
+    char* ptr = buffer->data + buffer->used;
+    uint32_t len = _out_format(ptr, num, is_signed, radix);
+    if (newline)
+        ptr[len++] = '\n';
+    return _out_commit_locked(buffer, len, newline);
+}
+
+static int _out_write_number(int fd, uint64_t num, bool is_signed, int radix, bool newline)
+{
+    pthread_mutex_lock(&buffers_lock);
+    int ret = _out_write_number_locked(fd, num, is_signed, radix, newline);
+    pthread_mutex_unlock(&buffers_lock);
+    return ret;
+}
+
+static int _out_write_uint(int fd, uint64_t num, int radix, bool newline)
+{
+    return _out_write_number(fd, num, false, radix, newline);
+}
+
+static int _out_write_sint(int fd, int64_t num, bool newline)
+{
+    return _out_write_number(fd, (uint64_t) num, true, 10, newline);
+}
+
+int flush_fd(int fd)
+{
+    if (fd != 1 && fd != 2)
+        return 0;
+    pthread_mutex_lock(&buffers_lock);
+    int ret = _out_flush_locked(_out_buffer_locked(fd));
+    pthread_mutex_unlock(&buffers_lock);
+    return ret;
+}
+
+int flush()
+{
+    pthread_mutex_lock(&buffers_lock);
+    int ret = _out_flush_locked(_out_buffer_locked(1));
+    int ret_err = _out_flush_locked(_out_buffer_locked(2));
+    pthread_mutex_unlock(&buffers_lock);
+    return (ret < 0) ? ret : ret_err;
+}
+
+int $fwrite(int fd, char const* ptr, uint64_t len)
+{
+    return _out_write(fd, ptr, len);
+}
+
+int $putchar(uint32_t ch)
+{
+    char c = (char) ch;
+    return _out_write(1, &c, 1);
+}
+
 int $fputs(int fd, string s)
 {
     char *ptr = str_data(s);
@@ -17,10 +224,7 @@ int $fputs(int fd, string s)
         ptr = "[[null]]";
         len = strlen(ptr);
     }
-    int ret = write(fd, ptr, len);
-    if (ret < 0)
-        return -_stdlib_errno;
-    return ret;
+    return _out_write(fd, ptr, len);
 }
 
 int $puts(string s)
@@ -35,72 +239,45 @@ int $eputs(string s)
 
 int putln_()
 {
-    int ret = write(1, "\n", 1);
-    if (ret < 0)
-        return -_stdlib_errno;
-    return ret;
+    return _out_write(1, "\n", 1);
 }
 
 int putln(string s)
 {
     int ret = $puts(s);
     if (ret < 0)
-        return  -_stdlib_errno;
+        return ret;
     return putln_();
 }
 
 int putln_u(uint64_t i)
 {
-    int ret = putuint(i);
-    if (ret < 0)
-        return ret;
-    ret = write(1, "\n", 1);
-    if (ret < 0)
-        return -_stdlib_errno;
-    return ret;
+    return _out_write_uint(1, i, 10, true);
 }
 
 int putln_s(int64_t i)
 {
-    int ret = putsint(i);
-    if (ret < 0)
-        return ret;
-    ret = write(1, "\n", 1);
-    if (ret < 0)
-        return -_stdlib_errno;
-    return ret;
+    return _out_write_sint(1, i, true);
 }
 
 int putsint(int64_t num)
 {
-    string s = to_string_s(num, 10);
-    int ret = $puts(s);
-    str_free(s);
-    return ret;
+    return _out_write_sint(1, num, false);
 }
 
 int putuint(uint64_t num)
 {
-    string s = to_string_u(num, 10);
-    int ret = $puts(s);
-    str_free(s);
-    return ret;
+    return _out_write_uint(1, num, 10, false);
 }
 
 int puthex(uint64_t num)
 {
-    string s = to_string_s(num, 16);
-    int ret = $puts(s);
-    str_free(s);
-    return ret;
+    return _out_write_uint(1, num, 16, false);
 }
 
 int cputs(char *s)
 {
-    int ret = write(1, s, strlen(s));
-    if (ret < 0)
-        return -_stdlib_errno;
-    return ret;
+    return _out_write(1, s, strlen(s));
 }
 
 int cputln(int8_t *s)
@@ -108,8 +285,5 @@ int cputln(int8_t *s)
     int ret = cputs((char *) s);
     if (ret < 0)
         return ret;
-    ret = write(1, "\n", 1);
-    if (ret < 0)
-        return -_stdlib_errno;
-    return ret;
+    return putln_();
 }
@@ -5,11 +5,13 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 
 #define STRING_IMPL
 
@@ -19,45 +21,138 @@ typedef enum _string_control_block_type {
     SMALL = 0x02,
     HEAP = 0x04,
     STATIC = 0x08,
+    BUILDER = 0x10,
+    MAPPED = 0x20,
+    INTERNED = 0x40,
 } string_control_block_type;
 
+#define POOL_SIZE 4096
+
+// Strings of up to SMALLSZ bytes are stored in the control block itself.
+// Their length is kept in the header, so that all of the last 24 bytes of
+// the block are available for the characters and a terminating \0. The
+// hash of the contents of other strings is computed when it's first needed,
+// and is 0 until then. Small strings don't cache their hash.
+#define SMALLSZ 23
+
 typedef struct _string_control_block {
     union {
         uint32_t count;
         int32_t next;
     };
-    string_control_block_type type;
-    uint32_t length;
-    char* data;
+    uint8_t type;
+    uint8_t small_length;
+    uint16_t pool;
+    union {
+        char small[SMALLSZ + 1];
+        struct {
+            uint32_t length;
+            uint32_t hash;
+            char* data;
+        };
+    };
 } string_control_block;
 
+_Static_assert(sizeof(string_control_block) == 32, "String control blocks should be 32 bytes");
+
+// Pools are registered in the pools array, and every control block knows
+// the index of the pool it belongs to. Pools with available slots are
+// linked in the free_pools list. This makes finding a free control block
+// and returning one to its pool O(1), no matter how many pools there are.
+//
+// Every thread that uses strings allocates from its own pools, so
+// allocating and releasing blocks is not synchronized. A block released by
+// another thread than the one owning its pool is pushed on the owner's
+// remote_free stack. The owner takes those back when it runs out of free
+// blocks.
+//
+// When a thread exits, its string_thread is retired. The next thread that
+// starts using strings adopts it, with its pools and remote_free stack, so
+// the blocks of exited threads are reused instead of leaked.
+typedef struct _string_thread {
+    struct _string_pool *free_pools;
+    struct _string_control_block *remote_free;
+    struct _string_thread *next_retired;
+} string_thread;
+
 typedef struct _string_pool {
-    string_control_block strings[4096];
+    string_control_block strings[POOL_SIZE];
     int32_t first;
-    struct _string_pool *next;
+    uint32_t index;
+    string_thread *owner;
+    struct _string_pool *next_free;
 } string_pool;
 
 typedef string_control_block* string;
 
 #include <rt/obelix.h>
+#include <rt/strkernels.h>
 
-#define SMALLSZ (sizeof(char*) - 1)
 #define IS_AVAILABLE(s) (s->type == AVAILABLE)
 #define IS_VIEW(s) (s->type & VIEW)
 #define IS_HEAP(s) (s->type & HEAP)
 #define IS_SMALL(s) (s->type & SMALL)
 #define IS_STATIC(s) (s->type & STATIC)
-#define DATA_PTR(s) (IS_SMALL(s) ? (char*) &s->data : s->data)
+#define IS_BUILDER(s) (s->type & BUILDER)
+#define IS_MAPPED(s) (s->type & MAPPED)
+#define IS_INTERNED(s) (s->type & INTERNED)
+#define DATA_PTR(s) (IS_SMALL(s) ? (char*) s->small : s->data)
+#define LENGTH(s) (IS_SMALL(s) ? (uint32_t) s->small_length : s->length)
+
+#define MAX_POOLS 65536
 
 static string_pool first_pool = { 0 };
-static string_pool *last_pool = &first_pool;
-static string_control_block empty_string = { .count=1, .type=SMALL | STATIC, .length=0, .data=NULL };
+static bool first_pool_taken = false;
+static string_pool *pools[MAX_POOLS] = { 0 };
+static uint32_t pool_count = 0;
+static string_control_block empty_string = { .count=1, .type=SMALL | STATIC | INTERNED, .small_length=0 };
+
+// Reference counts and statistics are only updated atomically once a second
+// thread has used a string. Single-threaded programs don't pay for atomics.
+// A thread registers the first time it allocates a string or takes or
+// releases a reference, so a thread that only works on strings it was
+// handed switches the runtime to atomics as well. Programs starting threads
+// should call str_thread_start() before they do, so the switch happens
+// before the new thread can race with the current one.
+static string_thread main_thread = { 0 };
+#ifndef OBELIX_RT_NO_TLS
+static _Thread_local string_thread *this_thread = NULL;
+#endif
+static uint32_t thread_count = 0;
+static bool threaded = false;
+static string_thread *retired_threads = NULL;
+static bool retired_lock = false;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static bool thread_key_created = false;
+
+#define THREADED() __atomic_load_n(&threaded, __ATOMIC_RELAXED)
+#define STAT_ADD(counter, n)                                        \
+    do {                                                            \
+        if (THREADED())                                             \
+            __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED);  \
+        else                                                        \
+            (counter) += (n);                                       \
+    } while (0)
+#define STAT_INC(counter) STAT_ADD(counter, 1)
 
 static size_t total_allocations = 0;
 static size_t total_allocation_size = 0;
+static size_t total_heap_allocations = 0;
 static size_t total_deallocations = 0;
+static size_t total_copies = 0;
+static size_t total_releases = 0;
 static size_t total_small_string_allocations = 0;
 static size_t total_string_view_allocations = 0;
+static size_t total_interned_strings = 0;
+
+// Interned strings are kept in an open addressing hash table. They are
+// marked STATIC, so they are never freed and copying them doesn't touch
+// the reference count.
+static string *intern_table = NULL;
+static size_t intern_capacity = 0;
+static size_t intern_count = 0;
+static bool intern_lock = false;
 
 static inline void _str_memclear(void *ptr, size_t sz)
 {
@@ -69,11 +164,6 @@ static inline void _str_memcopy(char *dest, char const* src, size_t num)
     __builtin_memcpy(dest, src, num);
 }
 
-static inline int _str_memcompare(char const* s1, char const* s2, size_t num)
-{
-    return __builtin_memcmp(s1, s2, num);
-}
-
 static inline char* _str_memalloc(size_t sz)
 {
     char* ret = malloc(sz);
@@ -88,47 +178,196 @@ static inline void _str_memfree(char* str)
         free(str);
 }
 
-static string _str_find_block()
+// Builder strings are heap strings with spare room at the end of their
+// buffer, so that appending to them doesn't have to copy what's already
+// there. The capacity of the buffer is stored in front of the data.
+#define BUILDER_HEADER sizeof(size_t)
+#define BUILDER_MIN_CAPACITY 32
+#define BUILDER_CAPACITY(s) (*(size_t*) (s->data - BUILDER_HEADER))
+
+static inline char* _str_builder_alloc(char* data, size_t capacity)
 {
-    string_pool *pool = last_pool;
-    if (pool->first < 0) {
-        pool = &first_pool;
-        while (pool && pool->first < 0)
-            pool = pool->next;
-        if (!pool) {
-            pool = (string_pool*) _str_memalloc(sizeof(string_pool));
-            last_pool->next = pool;
-            last_pool = pool;
-        }
+    char* buffer = realloc((data) ? data - BUILDER_HEADER : NULL, capacity + BUILDER_HEADER);
+    assert(buffer != NULL);
+    *(size_t*) buffer = capacity;
+    return buffer + BUILDER_HEADER;
+}
+
+static inline void _str_free_data(string s)
+{
+    if (IS_MAPPED(s))
+        munmap(s->data, (size_t) s->length + 1);
+    if (!IS_HEAP(s))
+        return;
+    _str_memfree((IS_BUILDER(s)) ? s->data - BUILDER_HEADER : s->data);
+}
+
+static void _str_retire_thread(void *ptr)
+{
+    string_thread *thread = (string_thread*) ptr;
+    while (__atomic_test_and_set(&retired_lock, __ATOMIC_ACQUIRE))
+        ;
+    thread->next_retired = retired_threads;
+    retired_threads = thread;
+    __atomic_clear(&retired_lock, __ATOMIC_RELEASE);
+}
+
+static void _str_create_thread_key()
+{
+    pthread_key_create(&thread_key, _str_retire_thread);
+    __atomic_store_n(&thread_key_created, true, __ATOMIC_RELEASE);
+}
+
+// Without thread-local storage, which the runtime linked by tcc can't use,
+// a thread's state is found through the thread key. That is slower, but
+// only used for quick test runs.
+static inline string_thread *_str_this_thread()
+{
+#ifdef OBELIX_RT_NO_TLS
+    if (!__atomic_load_n(&thread_key_created, __ATOMIC_ACQUIRE))
+        return NULL;
+    return (string_thread*) pthread_getspecific(thread_key);
+#else
+    return this_thread;
+#endif
+}
+
+static string_thread *_str_register_thread()
+{
+    string_thread *thread = NULL;
+    if (__atomic_fetch_add(&thread_count, 1, __ATOMIC_ACQ_REL) == 0) {
+        thread = &main_thread;
+    } else {
+        __atomic_store_n(&threaded, true, __ATOMIC_SEQ_CST);
+        while (__atomic_test_and_set(&retired_lock, __ATOMIC_ACQUIRE))
+            ;
+        thread = retired_threads;
+        if (thread)
+            retired_threads = thread->next_retired;
+        __atomic_clear(&retired_lock, __ATOMIC_RELEASE);
+        if (!thread)
+            thread = (string_thread*) _str_memalloc(sizeof(string_thread));
+        thread->next_retired = NULL;
     }
-    if (pool->first == 0 && pool->strings[0].next == 0) {
-        // This is the first time we're here:
-        for (int ix = 1; ix < 4096; ix++) {
-            pool->strings[ix-1].next = ix;
-        }
-        pool->strings[4095].next = -1;
+    pthread_once(&thread_key_once, _str_create_thread_key);
+    pthread_setspecific(thread_key, thread);
+#ifndef OBELIX_RT_NO_TLS
+    this_thread = thread;
+#endif
+    return thread;
+}
+
+static inline string_thread *_str_thread()
+{
+    string_thread *thread = _str_this_thread();
+    if (__builtin_expect(thread == NULL, 0))
+        return _str_register_thread();
+    return thread;
+}
+
+void str_thread_start()
+{
+    _str_thread();
+    __atomic_store_n(&threaded, true, __ATOMIC_SEQ_CST);
+}
+
+static void _str_add_pool(string_thread *thread)
+{
+    string_pool *pool;
+    if (!__atomic_exchange_n(&first_pool_taken, true, __ATOMIC_ACQ_REL)) {
+        pool = &first_pool;
         if (getenv("OBELIX_INSPECT_STRING_POOLS"))
             atexit(str_inspect_pools);
+    } else {
+        pool = (string_pool*) _str_memalloc(sizeof(string_pool));
+    }
+    pool->index = __atomic_fetch_add(&pool_count, 1, __ATOMIC_ACQ_REL);
+    assert(pool->index < MAX_POOLS);
+    pool->owner = thread;
+    for (int ix = 0; ix < POOL_SIZE; ix++) {
+        pool->strings[ix].next = (ix < POOL_SIZE - 1) ? ix + 1 : -1;
+        pool->strings[ix].pool = pool->index;
     }
+    pool->first = 0;
+    pool->next_free = thread->free_pools;
+    thread->free_pools = pool;
+    __atomic_store_n(&pools[pool->index], pool, __ATOMIC_RELEASE);
+}
+
+static void _str_return_block(string_thread *thread, string str)
+{
+    string_pool *pool = pools[str->pool];
+    assert(str >= pool->strings && str < pool->strings + POOL_SIZE);
+    str->type = AVAILABLE;
+    str->data = NULL;
+    str->length = 0;
+    if (pool->first < 0) {
+        pool->next_free = thread->free_pools;
+        thread->free_pools = pool;
+    }
+    str->next = pool->first;
+    pool->first = str - pool->strings;
+}
+
+static void _str_reclaim_remote_blocks(string_thread *thread)
+{
+    string str = __atomic_exchange_n(&thread->remote_free, NULL, __ATOMIC_ACQUIRE);
+    while (str) {
+        string next = (string) str->data;
+        _str_return_block(thread, str);
+        str = next;
+    }
+}
+
+static string _str_find_block()
+{
+    string_thread *thread = _str_thread();
+    if (!thread->free_pools && __atomic_load_n(&thread->remote_free, __ATOMIC_RELAXED))
+        _str_reclaim_remote_blocks(thread);
+    if (!thread->free_pools)
+        _str_add_pool(thread);
+    string_pool *pool = thread->free_pools;
     string str = &pool->strings[pool->first];
     assert(IS_AVAILABLE(str));
     assert(str->next < 0 || pool->strings[str->next].type == AVAILABLE);
     pool->first = str->next;
+    if (pool->first < 0) {
+        thread->free_pools = pool->next_free;
+        pool->next_free = NULL;
+    }
+    str->hash = 0;
     return str;
 }
 
+static void _str_release_block(string str)
+{
+    string_pool *pool = __atomic_load_n(&pools[str->pool], __ATOMIC_ACQUIRE);
+    string_thread *thread = _str_this_thread();
+    if (pool->owner == thread) {
+        _str_return_block(thread, str);
+        return;
+    }
+    // Lock-free push on the owner's stack. The owner takes the whole stack
+    // at once, so there is no ABA problem. The data pointer links the stack.
+    string_thread *owner = pool->owner;
+    str->type = AVAILABLE;
+    str->length = 0;
+    string head = __atomic_load_n(&owner->remote_free, __ATOMIC_RELAXED);
+    do {
+        str->data = (char*) head;
+    } while (!__atomic_compare_exchange_n(&owner->remote_free, &head, str, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
 void str_inspect_pools() {
-    int pool_count = 0;
     size_t total_allocated_strings = 0;
     size_t total_allocated = 0;
 
-    for (string_pool *pool = &first_pool; pool; pool = pool->next) {
-        pool_count++;
-    }
-    fprintf(stderr, "\nNumber of string pools: %d\n\n", pool_count);
-    pool_count = 0;
-    for (string_pool *pool = &first_pool; pool; pool = pool->next) {
-        fprintf(stderr, "~~~~~~~~~~~~~~ POOL #%d ~~~~~~~~~~~~~~\n", pool_count);
+    fprintf(stderr, "\nNumber of string pools: %u\n\n", pool_count);
+    for (uint32_t pool_ix = 0; pool_ix < pool_count; ++pool_ix) {
+        string_pool *pool = pools[pool_ix];
+        if (!pool)
+            continue;
+        fprintf(stderr, "~~~~~~~~~~~~~~ POOL #%u ~~~~~~~~~~~~~~\n", pool_ix);
         int unallocated_string_count = 0;
         if (pool->first < 0) {
             fprintf(stderr, "Pool is FULL\n");
@@ -140,17 +379,17 @@ void str_inspect_pools() {
                 ++unallocated_string_count;
             }
             fprintf(stderr, "Available slots: %d\n", unallocated_string_count);
-            total_allocated_strings += (4096 - unallocated_string_count);
+            total_allocated_strings += (POOL_SIZE - unallocated_string_count);
         }
         size_t allocated_by_pool = 0;
         int heap_strings_in_pool = 0;
         int small_strings_in_pool = 0;
         int views_in_pool = 0;
-        for (int ix = 0; ix < 4096; ++ix) {
+        for (int ix = 0; ix < POOL_SIZE; ++ix) {
             string s = &pool->strings[ix];
             if (IS_HEAP(s)) {
                 ++heap_strings_in_pool;
-                allocated_by_pool += s->length + 1;
+                allocated_by_pool += (IS_BUILDER(s)) ? BUILDER_CAPACITY(s) + BUILDER_HEADER : s->length + 1;
             }
             if (IS_SMALL(s))
                 ++small_strings_in_pool;
@@ -158,7 +397,7 @@ void str_inspect_pools() {
                 ++views_in_pool;
 
         }
-        fprintf(stderr, "Allocated slots: %d\n", 4096 - unallocated_string_count);
+        fprintf(stderr, "Allocated slots: %d\n", POOL_SIZE - unallocated_string_count);
         fprintf(stderr, "Heap strings: %d using %zu bytes\n", heap_strings_in_pool, allocated_by_pool);
         fprintf(stderr, "Small strings: %d\n", small_strings_in_pool);
         fprintf(stderr, "String views: %d\n", views_in_pool);
@@ -168,16 +407,20 @@ void str_inspect_pools() {
     fprintf(stderr, "Leaked slot allocations: %zu\n", total_allocated_strings);
     fprintf(stderr, "Leaked heap usage: %zu bytes\n\n", total_allocated);
     fprintf(stderr, "Total number of strings allocated: %zu\n", total_allocations);
+    fprintf(stderr, "Total number of heap allocations: %zu\n", total_heap_allocations);
     fprintf(stderr, "Total heap usage: %zu bytes\n", total_allocation_size);
     fprintf(stderr, "Total number of strings deallocated: %zu\n", total_deallocations);
+    fprintf(stderr, "Total number of reference count increments: %zu\n", total_copies);
+    fprintf(stderr, "Total number of reference count decrements: %zu\n", total_releases);
     fprintf(stderr, "Total number of small string allocations: %zu\n", total_small_string_allocations);
     fprintf(stderr, "Total number of string view allocations: %zu\n", total_string_view_allocations);
+    fprintf(stderr, "Total number of interned strings: %zu\n", total_interned_strings);
 }
 
 string str_view_for(char const* s)
 {
     assert(s);
-    ++total_string_view_allocations;
+    STAT_INC(total_string_view_allocations);
     if (*s == '\0') {
         return &empty_string;
     }
@@ -186,117 +429,192 @@ string str_view_for(char const* s)
     str->type = VIEW;
     str->length = strlen(s);
     str->data = (char*) s;
-    ++total_allocations;
+    STAT_INC(total_allocations);
     return str;
 }
 
-string str_allocate(char const* s)
+// Wraps a read-only mapping of a file. The mapping is owned by the
+// string, and is unmapped when the last reference to it goes away. It must
+// be length + 1 bytes long, the last one being a NUL.
+string str_view_mapped(char const* data, uint32_t length)
 {
-    assert(s);
-    if (*s == '\0') {
-        return &empty_string;
-    }
+    assert(data);
+    STAT_INC(total_string_view_allocations);
     string str = _str_find_block();
     str->count = 1;
-    str->length = strlen(s);
-    if (str->length <= SMALLSZ) {
-        ++total_small_string_allocations;
+    str->type = VIEW | MAPPED;
+    str->length = length;
+    str->data = (char*) data;
+    STAT_INC(total_allocations);
+    return str;
+}
+
+// Sets up str to hold length bytes, and returns where they should go.
+// Strings that fit are stored inline, longer ones get a heap buffer.
+static char* _str_alloc_data(string str, uint32_t length)
+{
+    if (length <= SMALLSZ) {
+        STAT_INC(total_small_string_allocations);
         str->type = SMALL;
-        intptr_t* buffer = (intptr_t*) &str->data;
-        *buffer = *(intptr_t*) s;
-    } else {
-        str->type = HEAP;
-        str->data = _str_memalloc(str->length);
-        _str_memcopy(str->data, s, str->length);
-        total_allocation_size += str->length;
+        str->small_length = length;
+        str->small[length] = '\0';
+        return str->small;
     }
-    ++total_allocations;
-    return str;
+    str->type = HEAP;
+    str->length = length;
+    str->data = _str_memalloc(length);
+    STAT_INC(total_heap_allocations);
+    STAT_ADD(total_allocation_size, length);
+    return str->data;
 }
 
-static string _str_adopt(char* s, bool free_small_string)
+static string _str_from_bytes(char const* data, uint32_t length)
 {
-    assert(s);
-    if (*s == '\0') {
-        free(s);
+    if (length == 0)
         return &empty_string;
-    }
     string str = _str_find_block();
     str->count = 1;
-    str->length = strlen(s);
-    if (str->length <= SMALLSZ) {
-        ++total_small_string_allocations;
-        str->type = SMALL;
-        intptr_t* buffer = (intptr_t*) &str->data;
-        *buffer = *(intptr_t*) s;
-        if (free_small_string)
-            free(s);
-    } else {
-        str->type = HEAP;
-        str->data = s;
-    }
+    _str_memcopy(_str_alloc_data(str, length), data, length);
+    STAT_INC(total_allocations);
     return str;
 }
 
+string str_allocate(char const* s)
+{
+    assert(s);
+    return _str_from_bytes(s, strlen(s));
+}
+
 string str_adopt(char* s)
 {
-    return _str_adopt(s, true);
+    assert(s);
+    uint32_t length = strlen(s);
+    if (length <= SMALLSZ) {
+        string str = _str_from_bytes(s, length);
+        free(s);
+        return str;
+    }
+    string str = _str_find_block();
+    str->count = 1;
+    str->type = HEAP;
+    str->length = length;
+    str->data = s;
+    STAT_INC(total_allocations);
+    return str;
 }
 
 string str_copy(string s)
 {
-    if (!IS_STATIC(s))
+    if (IS_STATIC(s))
+        return s;
+    _str_thread();
+    STAT_INC(total_copies);
+    if (THREADED())
+        __atomic_fetch_add(&s->count, 1, __ATOMIC_RELAXED);
+    else
         s->count++;
     return s;
 }
 
+// Generated code moves strings out of variables by setting them to NULL,
+// so releasing NULL is allowed.
 void str_free(string s)
 {
-    if (IS_STATIC(s))
+    if (!s || IS_STATIC(s))
         return;
-    if (--s->count == 0) {
-        if (IS_HEAP(s)) _str_memfree(s->data);
-        s->type = AVAILABLE;
-        s->data = NULL;
-        s->length = 0;
-        string_pool *pool = &first_pool;
-        while (pool && (s < pool->strings || s > (pool->strings + 4096)))
-            pool = pool->next;
-        assert(pool != NULL);
-        s->next = pool->first;
-        pool->first = s - pool->strings;
-        ++total_deallocations;
+    _str_thread();
+    STAT_INC(total_releases);
+    uint32_t count = (THREADED()) ? __atomic_sub_fetch(&s->count, 1, __ATOMIC_ACQ_REL) : --s->count;
+    if (count == 0) {
+        _str_free_data(s);
+        _str_release_block(s);
+        STAT_INC(total_deallocations);
     }
 }
 
 string str_concat(string s1, string s2)
 {
-    char *s;
-    intptr_t buffer = 0;
-    if (s1->length + s2->length > SMALLSZ) {
-        s = _str_memalloc(s1->length + s2->length);
-    } else {
-        s = (char*) &buffer;
+    uint32_t length1 = LENGTH(s1);
+    uint32_t length2 = LENGTH(s2);
+    if (length1 + length2 == 0)
+        return &empty_string;
+    string str = _str_find_block();
+    str->count = 1;
+    char* data = _str_alloc_data(str, length1 + length2);
+    _str_memcopy(data, DATA_PTR(s1), length1);
+    _str_memcopy(data + length1, DATA_PTR(s2), length2);
+    STAT_INC(total_allocations);
+    return str;
+}
+
+string str_builder(uint32_t capacity)
+{
+    if (capacity < BUILDER_MIN_CAPACITY)
+        capacity = BUILDER_MIN_CAPACITY;
+    string str = _str_find_block();
+    str->count = 1;
+    str->type = HEAP | BUILDER;
+    str->length = 0;
+    str->data = _str_builder_alloc(NULL, capacity);
+    STAT_ADD(total_allocation_size, capacity);
+    STAT_INC(total_allocations);
+    return str;
+}
+
+// Appends piece to s, and returns the result. Takes over the caller's
+// references to both s and piece. If the caller held the only reference
+// to s, and s is a builder string, piece is copied into the spare room of
+// s, which is grown geometrically if necessary. Otherwise s is copied
+// into a new builder string first. Appending to the same string over and
+// over again therefore takes amortized linear time.
+string str_append(string s, string piece)
+{
+    uint32_t piece_length = LENGTH(piece);
+    if (piece_length == 0) {
+        str_free(piece);
+        return s;
+    }
+    uint32_t s_length = LENGTH(s);
+    size_t length = (size_t) s_length + piece_length;
+    assert(length <= UINT32_MAX);
+    _str_thread();
+    uint32_t count = (THREADED()) ? __atomic_load_n(&s->count, __ATOMIC_ACQUIRE) : s->count;
+    if (!IS_BUILDER(s) || count != 1) {
+        string builder = str_builder((length > s_length * 2) ? length : s_length * 2);
+        _str_memcopy(builder->data, DATA_PTR(s), s_length);
+        builder->length = s_length;
+        str_free(s);
+        s = builder;
     }
-    _str_memcopy(s, DATA_PTR(s1), s1->length);
-    _str_memcopy(s + s1->length, DATA_PTR(s2), s2->length);
-    return _str_adopt(s, false);
+    size_t capacity = BUILDER_CAPACITY(s);
+    if (length > capacity) {
+        while (capacity < length)
+            capacity *= 2;
+        STAT_ADD(total_allocation_size, capacity - BUILDER_CAPACITY(s));
+        s->data = _str_builder_alloc(s->data, capacity);
+    }
+    _str_memcopy(s->data + s->length, DATA_PTR(piece), piece_length);
+    s->length = length;
+    s->hash = 0;
+    str_free(piece);
+    return s;
 }
 
 string str_multiply(string str, uint32_t count)
 {
-    char *s;
-    intptr_t buffer = 0;
-    if (str->length * count > SMALLSZ) {
-        s = _str_memalloc(str->length * count);
-    } else {
-        s = (char*) &buffer;
-    }
+    uint32_t length = LENGTH(str);
+    size_t total = (size_t) length * count;
+    assert(total <= UINT32_MAX);
+    if (total == 0)
+        return &empty_string;
+    string ret = _str_find_block();
+    ret->count = 1;
+    char* data = _str_alloc_data(ret, total);
     for (uint32_t ix = 0; ix < count; ++ix) {
-        _str_memcopy(s + ix * str->length, DATA_PTR(str), str->length);
+        _str_memcopy(data + ix * length, DATA_PTR(str), length);
     }
-    s[str->length * count] = '\0';
-    return _str_adopt(s, false);
+    STAT_INC(total_allocations);
+    return ret;
 }
 
 char * str_data(string s)
@@ -306,52 +624,286 @@ char * str_data(string s)
 
 uint32_t str_length(string s)
 {
-    return s->length;
+    return LENGTH(s);
 }
 
 int str_compare(string s1, string s2)
 {
-    int ret = _str_memcompare(DATA_PTR(s1), DATA_PTR(s2), (s1->length > s2->length) ? s2->length : s1->length);
-    if (!ret)
-        ret = s1->length - s2->length;
+    if (s1 == s2)
+        return 0;
+    uint32_t length1 = LENGTH(s1);
+    uint32_t length2 = LENGTH(s2);
+    size_t len = (length1 > length2) ? length2 : length1;
+    char const* data1 = DATA_PTR(s1);
+    char const* data2 = DATA_PTR(s2);
+    size_t ix = str_kernel_mismatch(data1, data2, len);
+    if (ix < len)
+        return (int) (unsigned char) data1[ix] - (int) (unsigned char) data2[ix];
+    return (int) length1 - (int) length2;
+}
+
+bool str_equals(string s1, string s2)
+{
+    if (s1 == s2)
+        return true;
+    uint32_t length = LENGTH(s1);
+    if (length != LENGTH(s2))
+        return false;
+    if (IS_INTERNED(s1) && IS_INTERNED(s2))
+        return false;
+    if (!IS_SMALL(s1) && !IS_SMALL(s2)) {
+        uint32_t hash1 = __atomic_load_n(&s1->hash, __ATOMIC_RELAXED);
+        uint32_t hash2 = __atomic_load_n(&s2->hash, __ATOMIC_RELAXED);
+        if (hash1 && hash2 && hash1 != hash2)
+            return false;
+    }
+    return str_kernel_mismatch(DATA_PTR(s1), DATA_PTR(s2), length) == length;
+}
+
+static uint32_t _str_hash_bytes(char const* data, uint32_t length)
+{
+    // FNV-1a. 0 means 'not computed yet', so that's mapped to 1.
+    uint32_t hash = 2166136261u;
+    for (uint32_t ix = 0; ix < length; ++ix) {
+        hash ^= (uint8_t) data[ix];
+        hash *= 16777619u;
+    }
+    return (hash) ? hash : 1;
+}
+
+uint32_t str_hash(string s)
+{
+    if (IS_SMALL(s))
+        return _str_hash_bytes(s->small, s->small_length);
+    uint32_t hash = __atomic_load_n(&s->hash, __ATOMIC_RELAXED);
+    if (!hash) {
+        hash = _str_hash_bytes(DATA_PTR(s), s->length);
+        __atomic_store_n(&s->hash, hash, __ATOMIC_RELAXED);
+    }
+    return hash;
+}
+
+static void _str_intern_insert(string str)
+{
+    if ((intern_count + 1) * 2 > intern_capacity) {
+        size_t capacity = (intern_capacity) ? intern_capacity * 2 : 256;
+        string *table = calloc(capacity, sizeof(string));
+        assert(table != NULL);
+        for (size_t ix = 0; ix < intern_capacity; ++ix) {
+            if (!intern_table[ix])
+                continue;
+            size_t jx = str_hash(intern_table[ix]) & (capacity - 1);
+            while (table[jx])
+                jx = (jx + 1) & (capacity - 1);
+            table[jx] = intern_table[ix];
+        }
+        free(intern_table);
+        intern_table = table;
+        intern_capacity = capacity;
+    }
+    size_t ix = str_hash(str) & (intern_capacity - 1);
+    while (intern_table[ix])
+        ix = (ix + 1) & (intern_capacity - 1);
+    intern_table[ix] = str;
+    intern_count++;
+}
+
+// Returns the interned string with the given contents, creating it if it
+// doesn't exist yet. If literal is set, data is a string literal and the
+// interned string can point to it instead of to a copy.
+static string _str_intern(char const* data, uint32_t length, uint32_t hash, bool literal)
+{
+    if (length == 0)
+        return &empty_string;
+    while (__atomic_test_and_set(&intern_lock, __ATOMIC_ACQUIRE))
+        ;
+    if (intern_capacity) {
+        for (size_t ix = hash & (intern_capacity - 1); intern_table[ix]; ix = (ix + 1) & (intern_capacity - 1)) {
+            string candidate = intern_table[ix];
+            if ((IS_SMALL(candidate) || candidate->hash == hash) && LENGTH(candidate) == length && !memcmp(DATA_PTR(candidate), data, length)) {
+                __atomic_clear(&intern_lock, __ATOMIC_RELEASE);
+                return candidate;
+            }
+        }
+    }
+    string str = _str_find_block();
+    str->count = 1;
+    if (literal) {
+        str->type = VIEW | STATIC | INTERNED;
+        str->length = length;
+        str->hash = hash;
+        str->data = (char*) data;
+    } else {
+        _str_memcopy(_str_alloc_data(str, length), data, length);
+        if (!IS_SMALL(str))
+            str->hash = hash;
+        str->type |= STATIC | INTERNED;
+    }
+    _str_intern_insert(str);
+    STAT_INC(total_interned_strings);
+    __atomic_clear(&intern_lock, __ATOMIC_RELEASE);
+    return str;
+}
+
+string str_intern(string s)
+{
+    if (IS_INTERNED(s))
+        return s;
+    return _str_intern(DATA_PTR(s), LENGTH(s), str_hash(s), false);
+}
+
+string str_intern_literal(char const* s)
+{
+    uint32_t length = strlen(s);
+    return _str_intern(s, length, _str_hash_bytes(s, length), true);
+}
+
+string str_literal(string *cache, char const* s)
+{
+    string ret = __atomic_load_n(cache, __ATOMIC_ACQUIRE);
+    if (!ret) {
+        ret = str_intern_literal(s);
+        __atomic_store_n(cache, ret, __ATOMIC_RELEASE);
+    }
     return ret;
 }
 
+int64_t str_find(string haystack, string needle)
+{
+    return str_kernel_find(DATA_PTR(haystack), LENGTH(haystack), DATA_PTR(needle), LENGTH(needle));
+}
 
-string to_string_s(int64_t num, int radix)
+uint64_t cstrlen(char const* s)
 {
-    char buf[65];
-    buf[64] = 0;
-    char* ptr = &buf[64];
+    return str_kernel_strlen(s);
+}
 
-    int sign = num < 0;
-    if (sign)
-        num = -num;
-    if (radix == 0)
-        radix = 10;
-    do {
-        uint32_t digit = num % radix;
-        *(--ptr) = (digit < 10) ? (digit + '0') : (digit - 10 + 'A');
-        num /= radix;
-    } while (num > 0);
-    if (sign)
-        *(--ptr) = '-';
-    return str_allocate(ptr);
+
+static char const digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static char const hex_digits[] = "0123456789ABCDEF";
+
+static uint64_t const powers_of_10[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull
+};
+
+static inline uint32_t _str_decimal_length(uint64_t num)
+{
+    // 1233/4096 is just under log10(2), so this is the number of digits of
+    // num, or one more than that. Or-ing in 1 makes 0 come out as 1 digit.
+    num |= 1;
+    uint32_t len = ((64 - __builtin_clzll(num)) * 1233 >> 12) + 1;
+    return len - (num < powers_of_10[len - 1]);
 }
 
-string to_string_u(uint64_t num, int radix)
+static inline uint32_t _str_format_length(uint64_t num, int radix)
+{
+    switch (radix) {
+    case 10:
+        return _str_decimal_length(num);
+    case 16:
+        return (num) ? (64 - __builtin_clzll(num) + 3) / 4 : 1;
+    default: {
+        uint32_t ret = 1;
+        while (num >= (uint64_t) radix) {
+            num /= radix;
+            ++ret;
+        }
+        return ret;
+    }
+    }
+}
+
+// Writes the digits of num backwards, ending just before end. Decimals and
+// hex numbers are written two digits at a time.
+static inline void _str_format_digits(char* end, uint64_t num, int radix)
 {
-    char buf[65];
-    buf[64] = 0;
-    char* ptr = &buf[64];
+    switch (radix) {
+    case 10:
+        while (num >= 100) {
+            uint32_t pair = (uint32_t) (num % 100) * 2;
+            num /= 100;
+            *(--end) = digit_pairs[pair + 1];
+            *(--end) = digit_pairs[pair];
+        }
+        if (num >= 10) {
+            *(--end) = digit_pairs[num * 2 + 1];
+            *(--end) = digit_pairs[num * 2];
+        } else {
+            *(--end) = (char) ('0' + num);
+        }
+        break;
+    case 16:
+        while (num >= 0x100) {
+            *(--end) = hex_digits[num & 0x0F];
+            *(--end) = hex_digits[(num >> 4) & 0x0F];
+            num >>= 8;
+        }
+        if (num >= 0x10)
+            *(--end) = hex_digits[num & 0x0F];
+        *(--end) = hex_digits[num >> ((num >= 0x10) ? 4 : 0)];
+        break;
+    default:
+        do {
+            uint32_t digit = num % radix;
+            *(--end) = (char) ((digit < 10) ? (digit + '0') : (digit - 10 + 'A'));
+            num /= radix;
+        } while (num > 0);
+    }
+}
 
+static uint32_t _str_format(char* buffer, uint64_t num, bool negative, int radix)
+{
     if (radix == 0)
         radix = 10;
-    do {
-        ptr--;
-        int digit = num % radix;
-        *ptr = (digit < 10) ? (digit + '0') : (digit - 10 + 'A');
-        num /= radix;
-    } while (num > 0);
-    return str_allocate(ptr);
+    assert(radix >= 2 && radix <= 36);
+    uint32_t len = _str_format_length(num, radix) + (negative ? 1 : 0);
+    _str_format_digits(buffer + len, num, radix);
+    if (negative)
+        *buffer = '-';
+    return len;
+}
+
+uint32_t str_format_s(char* buffer, int64_t num, int radix)
+{
+    uint64_t magnitude = (num < 0) ? -(uint64_t) num : (uint64_t) num;
+    return _str_format(buffer, magnitude, num < 0, radix);
+}
+
+uint32_t str_format_u(char* buffer, uint64_t num, int radix)
+{
+    return _str_format(buffer, num, false, radix);
+}
+
+// Most numbers fit in the inline storage of a small string, so they are
+// formatted straight into the control block.
+static string _str_from_number(uint64_t num, bool negative, int radix)
+{
+    char buffer[STR_FORMAT_BUFSZ];
+    uint32_t len = _str_format(buffer, num, negative, radix);
+    return _str_from_bytes(buffer, len);
+}
+
+string to_string_s(int64_t num, int radix)
+{
+    uint64_t magnitude = (num < 0) ? -(uint64_t) num : (uint64_t) num;
+    return _str_from_number(magnitude, num < 0, radix);
+}
+
+string to_string_u(uint64_t num, int radix)
+{
+    return _str_from_number(num, false, radix);
 }
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "strkernels.h"
+
+// The strlen kernels read whole aligned vectors, which can extend past the
+// terminating null byte. Aligned loads never cross a page boundary, so this
+// is safe, but the address sanitizer doesn't know that.
+#define STRLEN_KERNEL __attribute__((no_sanitize_address))
+
+typedef size_t (*mismatch_kernel)(char const*, char const*, size_t);
+typedef int64_t (*find_kernel)(char const*, size_t, char const*, size_t);
+typedef size_t (*strlen_kernel)(char const*);
+
+typedef struct _str_kernel_set {
+    char const* isa;
+    mismatch_kernel mismatch;
+    find_kernel find;
+    strlen_kernel strlen;
+} str_kernel_set;
+
+size_t str_kernel_mismatch_scalar(char const* s1, char const* s2, size_t len)
+{
+    for (size_t ix = 0; ix < len; ++ix) {
+        if (s1[ix] != s2[ix])
+            return ix;
+    }
+    return len;
+}
+
+int64_t str_kernel_find_scalar(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len)
+{
+    if (needle_len == 0)
+        return 0;
+    if (needle_len > haystack_len)
+        return -1;
+    for (size_t ix = 0; ix <= haystack_len - needle_len; ++ix) {
+        size_t jx = 0;
+        while (jx < needle_len && haystack[ix + jx] == needle[jx])
+            ++jx;
+        if (jx == needle_len)
+            return (int64_t) ix;
+    }
+    return -1;
+}
+
+size_t str_kernel_strlen_scalar(char const* s)
+{
+    char const* ptr = s;
+    while (*ptr)
+        ++ptr;
+    return ptr - s;
+}
+
+// The vectorized find kernels compare the first and the last byte of the
+// needle against a vector's worth of candidate positions at once, and only
+// compare the bytes in between for candidates where both match.
+static inline bool _find_verify(char const* candidate, char const* needle, size_t needle_len)
+{
+    return needle_len <= 2 || memcmp(candidate + 1, needle + 1, needle_len - 2) == 0;
+}
+
+static inline int64_t _find_tail(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len, size_t start)
+{
+    int64_t ret = str_kernel_find_scalar(haystack + start, haystack_len - start, needle, needle_len);
+    return (ret < 0) ? -1 : (int64_t) start + ret;
+}
+
+#if defined(__x86_64__)
+
+static size_t _mismatch_sse2(char const* s1, char const* s2, size_t len)
+{
+    size_t ix = 0;
+    for (; ix + 16 <= len; ix += 16) {
+        __m128i v1 = _mm_loadu_si128((__m128i const*) (s1 + ix));
+        __m128i v2 = _mm_loadu_si128((__m128i const*) (s2 + ix));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) ^ 0xFFFFu;
+        if (mask)
+            return ix + __builtin_ctz(mask);
+    }
+    return ix + str_kernel_mismatch_scalar(s1 + ix, s2 + ix, len - ix);
+}
+
+static int64_t _find_sse2(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len)
+{
+    if (needle_len == 0)
+        return 0;
+    if (needle_len > haystack_len)
+        return -1;
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t candidates = haystack_len - needle_len + 1;
+    size_t ix = 0;
+    for (; ix + 16 <= candidates; ix += 16) {
+        __m128i block_first = _mm_loadu_si128((__m128i const*) (haystack + ix));
+        __m128i block_last = _mm_loadu_si128((__m128i const*) (haystack + ix + needle_len - 1));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            size_t candidate = ix + __builtin_ctz(mask);
+            if (_find_verify(haystack + candidate, needle, needle_len))
+                return (int64_t) candidate;
+            mask &= mask - 1;
+        }
+    }
+    return _find_tail(haystack, haystack_len, needle, needle_len, ix);
+}
+
+STRLEN_KERNEL static size_t _strlen_sse2(char const* s)
+{
+    uintptr_t offset = (uintptr_t) s & 15;
+    char const* ptr = s - offset;
+    __m128i zero = _mm_setzero_si128();
+    uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((__m128i const*) ptr), zero)) >> offset;
+    if (mask)
+        return __builtin_ctz(mask);
+    for (;;) {
+        ptr += 16;
+        mask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((__m128i const*) ptr), zero));
+        if (mask)
+            return ptr + __builtin_ctz(mask) - s;
+    }
+}
+
+__attribute__((target("avx2"))) static size_t _mismatch_avx2(char const* s1, char const* s2, size_t len)
+{
+    size_t ix = 0;
+    for (; ix + 32 <= len; ix += 32) {
+        __m256i v1 = _mm256_loadu_si256((__m256i const*) (s1 + ix));
+        __m256i v2 = _mm256_loadu_si256((__m256i const*) (s2 + ix));
+        uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v1, v2));
+        if (mask)
+            return ix + __builtin_ctz(mask);
+    }
+    return ix + _mismatch_sse2(s1 + ix, s2 + ix, len - ix);
+}
+
+__attribute__((target("avx2"))) static int64_t _find_avx2(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len)
+{
+    if (needle_len == 0)
+        return 0;
+    if (needle_len > haystack_len)
+        return -1;
+    __m256i first = _mm256_set1_epi8(needle[0]);
+    __m256i last = _mm256_set1_epi8(needle[needle_len - 1]);
+    size_t candidates = haystack_len - needle_len + 1;
+    size_t ix = 0;
+    for (; ix + 32 <= candidates; ix += 32) {
+        __m256i block_first = _mm256_loadu_si256((__m256i const*) (haystack + ix));
+        __m256i block_last = _mm256_loadu_si256((__m256i const*) (haystack + ix + needle_len - 1));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last)));
+        while (mask) {
+            size_t candidate = ix + __builtin_ctz(mask);
+            if (_find_verify(haystack + candidate, needle, needle_len))
+                return (int64_t) candidate;
+            mask &= mask - 1;
+        }
+    }
+    int64_t ret = _find_sse2(haystack + ix, haystack_len - ix, needle, needle_len);
+    return (ret < 0) ? -1 : (int64_t) ix + ret;
+}
+
+STRLEN_KERNEL __attribute__((target("avx2"))) static size_t _strlen_avx2(char const* s)
+{
+    uintptr_t offset = (uintptr_t) s & 31;
+    char const* ptr = s - offset;
+    __m256i zero = _mm256_setzero_si256();
+    uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((__m256i const*) ptr), zero)) >> offset;
+    if (mask)
+        return __builtin_ctz(mask);
+    for (;;) {
+        ptr += 32;
+        mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((__m256i const*) ptr), zero));
+        if (mask)
+            return ptr + __builtin_ctz(mask) - s;
+    }
+}
+
+static str_kernel_set const sse2_kernels = { "sse2", _mismatch_sse2, _find_sse2, _strlen_sse2 };
+static str_kernel_set const avx2_kernels = { "avx2", _mismatch_avx2, _find_avx2, _strlen_avx2 };
+
+static str_kernel_set const* _select_kernels()
+{
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx2")) ? &avx2_kernels : &sse2_kernels;
+}
+
+#elif defined(__aarch64__)
+
+// NEON has no movemask. Narrowing the comparison result by 4 bits gives a
+// 64 bit mask with a nibble per byte, of which we keep one bit.
+static inline uint64_t _neon_mask(uint8x16_t eq)
+{
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+}
+
+static size_t _mismatch_neon(char const* s1, char const* s2, size_t len)
+{
+    size_t ix = 0;
+    for (; ix + 16 <= len; ix += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8((uint8_t const*) (s1 + ix)), vld1q_u8((uint8_t const*) (s2 + ix)));
+        uint64_t mask = _neon_mask(eq) ^ 0x8888888888888888ull;
+        if (mask)
+            return ix + (__builtin_ctzll(mask) >> 2);
+    }
+    return ix + str_kernel_mismatch_scalar(s1 + ix, s2 + ix, len - ix);
+}
+
+static int64_t _find_neon(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len)
+{
+    if (needle_len == 0)
+        return 0;
+    if (needle_len > haystack_len)
+        return -1;
+    uint8x16_t first = vdupq_n_u8((uint8_t) needle[0]);
+    uint8x16_t last = vdupq_n_u8((uint8_t) needle[needle_len - 1]);
+    size_t candidates = haystack_len - needle_len + 1;
+    size_t ix = 0;
+    for (; ix + 16 <= candidates; ix += 16) {
+        uint8x16_t block_first = vld1q_u8((uint8_t const*) (haystack + ix));
+        uint8x16_t block_last = vld1q_u8((uint8_t const*) (haystack + ix + needle_len - 1));
+        uint64_t mask = _neon_mask(vandq_u8(vceqq_u8(block_first, first), vceqq_u8(block_last, last)));
+        while (mask) {
+            size_t candidate = ix + (__builtin_ctzll(mask) >> 2);
+            if (_find_verify(haystack + candidate, needle, needle_len))
+                return (int64_t) candidate;
+            mask &= mask - 1;
+        }
+    }
+    return _find_tail(haystack, haystack_len, needle, needle_len, ix);
+}
+
+STRLEN_KERNEL static size_t _strlen_neon(char const* s)
+{
+    uintptr_t offset = (uintptr_t) s & 15;
+    char const* ptr = s - offset;
+    uint8x16_t zero = vdupq_n_u8(0);
+    uint64_t mask = _neon_mask(vceqq_u8(vld1q_u8((uint8_t const*) ptr), zero)) >> (offset * 4);
+    if (mask)
+        return __builtin_ctzll(mask) >> 2;
+    for (;;) {
+        ptr += 16;
+        mask = _neon_mask(vceqq_u8(vld1q_u8((uint8_t const*) ptr), zero));
+        if (mask)
+            return ptr + (__builtin_ctzll(mask) >> 2) - s;
+    }
+}
+
+static str_kernel_set const neon_kernels = { "neon", _mismatch_neon, _find_neon, _strlen_neon };
+
+static str_kernel_set const* _select_kernels()
+{
+    return &neon_kernels;
+}
+
+#else
+
+static str_kernel_set const scalar_kernels = { "scalar", str_kernel_mismatch_scalar, str_kernel_find_scalar, str_kernel_strlen_scalar };
+
+static str_kernel_set const* _select_kernels()
+{
+    return &scalar_kernels;
+}
+
+#endif
+
+static str_kernel_set const* _kernels()
+{
+    static str_kernel_set const* kernels = NULL;
+    str_kernel_set const* ret = __atomic_load_n(&kernels, __ATOMIC_ACQUIRE);
+    if (!ret) {
+        ret = _select_kernels();
+        __atomic_store_n(&kernels, ret, __ATOMIC_RELEASE);
+    }
+    return ret;
+}
+
+size_t str_kernel_mismatch(char const* s1, char const* s2, size_t len)
+{
+    return _kernels()->mismatch(s1, s2, len);
+}
+
+int64_t str_kernel_find(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len)
+{
+    return _kernels()->find(haystack, haystack_len, needle, needle_len);
+}
+
+size_t str_kernel_strlen(char const* s)
+{
+    return _kernels()->strlen(s);
+}
+
+char const* str_kernel_isa()
+{
+    return _kernels()->isa;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef __OBELIX_STRKERNELS_H__
+#define __OBELIX_STRKERNELS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte string primitives used by the string runtime. The str_kernel_*
+// functions use the widest vector instructions the CPU supports, and the
+// str_kernel_*_scalar ones are plain loops to compare them against.
+
+// Returns the index of the first byte where s1 and s2 differ, or len if
+// they are equal.
+extern size_t str_kernel_mismatch(char const* s1, char const* s2, size_t len);
+extern size_t str_kernel_mismatch_scalar(char const* s1, char const* s2, size_t len);
+
+// Returns the index of the first occurrence of needle in haystack, or -1.
+extern int64_t str_kernel_find(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len);
+extern int64_t str_kernel_find_scalar(char const* haystack, size_t haystack_len, char const* needle, size_t needle_len);
+
+// Returns the length of a null-terminated string.
+extern size_t str_kernel_strlen(char const* s);
+extern size_t str_kernel_strlen_scalar(char const* s);
+
+// Returns the name of the instruction set the kernels use.
+extern char const* str_kernel_isa();
+
+#endif /* __OBELIX_STRKERNELS_H__ */
@@ -0,0 +1,62 @@
+#  Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+#
+#  SPDX-License-Identifier: MIT
+
+#
+# Compares the C code the transpiler generates for an arithmetic-heavy
+# program with and without --no-direct-intrinsics. Reports the size of the
+# generated C and the time the C compiler takes to compile it.
+#
+# Usage:
+#   python3 c_output.py [--functions N] [--runs N] obelix
+#
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from processor_throughput import generate
+
+
+def run(obelix: str, source: str, flags: list[str]) -> tuple[int, float]:
+    workdir = os.path.dirname(source)
+    stats_file = os.path.join(workdir, "stats.json")
+    proc = subprocess.run([obelix, "--force", "--keep-c-file", "--no-object-cache", f"--stats-json={stats_file}"]
+                          + flags + [source], cwd=workdir, capture_output=True, text=True)
+    if proc.returncode != 0:
+        print(proc.stdout, proc.stderr, file=sys.stderr)
+        sys.exit(f"{obelix} failed with exit code {proc.returncode}")
+    size = sum(os.path.getsize(f) for f in glob.glob(os.path.join(workdir, ".obelix", "*.[ch]")))
+    with open(stats_file) as f:
+        stats = json.load(f)
+    cc = sum(phase["seconds"] for phase in stats.get("phases", []) if phase["phase"] == "cc")
+    return size, cc
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Obelix generated C benchmark")
+    parser.add_argument("--functions", type=int, default=200)
+    parser.add_argument("--statements", type=int, default=25)
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("obelix")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, "bench.obl")
+        with open(source, "w") as f:
+            f.write(generate(args.functions, args.statements))
+        print(f"{args.functions} functions, {args.functions * (args.statements + 1)} statements, "
+              f"best of {args.runs} runs")
+        for label, flags in (("statement expressions", ["--no-direct-intrinsics"]), ("direct expressions", [])):
+            results = [run(args.obelix, source, flags) for _ in range(args.runs)]
+            size = results[0][0]
+            cc = min(r[1] for r in results)
+            print(f"{label:<24} {size:>10} bytes of C, cc {cc:.3f}s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//
+// Measures the throughput of integer formatting in the runtime: to_string_s,
+// which is what int_to_string compiles to, and putln with an integer
+// argument. Both are compared with the digit-at-a-time loop the runtime
+// used to have.
+//
+// Usage, from the root of the source tree:
+//   cc -O2 -Isrc -Isrc/rt test/bench/int_format.c src/rt/string.c src/rt/strkernels.c src/rt/puts.c -o int_format -lpthread
+//   ./int_format [count in millions] > /dev/null
+//
+// Results are written to stderr.
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rt/obelix.h>
+
+#ifndef __APPLE__
+int* __error(void)
+{
+    return &errno;
+}
+#endif
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static string generic_to_string(int64_t num)
+{
+    char buf[65];
+    buf[64] = 0;
+    char* ptr = &buf[64];
+    uint64_t magnitude = (num < 0) ? -(uint64_t) num : (uint64_t) num;
+    do {
+        *(--ptr) = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (num < 0)
+        *(--ptr) = '-';
+    return str_allocate(ptr);
+}
+
+static int generic_putln(int64_t num)
+{
+    string s = generic_to_string(num);
+    int ret = write(1, str_data(s), str_length(s));
+    str_free(s);
+    if (ret >= 0)
+        ret = write(1, "\n", 1);
+    return ret;
+}
+
+static volatile uint64_t sink;
+
+static void report(char const* label, size_t count, double seconds)
+{
+    fprintf(stderr, "    %-10s %8.3f s %8.1f M/s %6.1f ns/number\n", label, seconds, (double) count / seconds / 1e6,
+        seconds * 1e9 / (double) count);
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = ((argc > 1) ? (size_t) atol(argv[1]) : 10) * 1000000;
+
+    // A mix of small and large, positive and negative numbers.
+    int64_t* numbers = malloc(count * sizeof(int64_t));
+    srand(42);
+    for (size_t ix = 0; ix < count; ++ix) {
+        int64_t n = rand();
+        switch (ix % 4) {
+        case 0: n %= 100; break;
+        case 1: n %= 100000; break;
+        case 2: n = -n; break;
+        default: n = n * (int64_t) rand(); break;
+        }
+        numbers[ix] = n;
+    }
+
+    fprintf(stderr, "%zu numbers\nint_to_string\n", count);
+    double start = now();
+    for (size_t ix = 0; ix < count; ++ix) {
+        string s = generic_to_string(numbers[ix]);
+        sink += str_length(s);
+        str_free(s);
+    }
+    report("generic", count, now() - start);
+    start = now();
+    for (size_t ix = 0; ix < count; ++ix) {
+        string s = to_string_s(numbers[ix], 10);
+        sink += str_length(s);
+        str_free(s);
+    }
+    report("runtime", count, now() - start);
+
+    fprintf(stderr, "putln\n");
+    start = now();
+    for (size_t ix = 0; ix < count; ++ix)
+        generic_putln(numbers[ix]);
+    report("generic", count, now() - start);
+    start = now();
+    for (size_t ix = 0; ix < count; ++ix)
+        putln_s(numbers[ix]);
+    flush();
+    report("runtime", count, now() - start);
+
+    free(numbers);
+    return 0;
+}
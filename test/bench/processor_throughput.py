@@ -0,0 +1,98 @@
+#  Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+#
+#  SPDX-License-Identifier: MIT
+
+#
+# Measures how fast the compiler front end gets through a large,
+# expression-heavy program. The program is generated, and then compiled
+# up to and including materialization, so the C compiler and linker are
+# not part of the measurement.
+#
+# Usage:
+#   python3 processor_throughput.py [--functions N] [--runs N] obelix [obelix ...]
+#
+# Passing more than one compiler executable, for example one configured
+# with -DOBELIX_TRACE=ON and one with -DOBELIX_TRACE=OFF, compares them on
+# the same program. For compilers that support --stats-json, the node
+# throughput of every pass of the fastest run is reported as well.
+#
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def generate(num_functions: int, statements: int) -> str:
+    lines = []
+    for f in range(num_functions):
+        lines.append(f"func f{f}(a: s64, b: s64) : s64")
+        lines.append("{")
+        lines.append("  var x0: s64 = a;")
+        for s in range(1, statements):
+            lines.append(f"  var x{s}: s64 = (x{s - 1} + a * {s}) - (b / {s + 1}) + {f};")
+        lines.append(f"  return x{statements - 1};")
+        lines.append("}")
+        lines.append("")
+    lines.append("func main() : s32")
+    lines.append("{")
+    lines.append("  var sum: s64 = 0;")
+    for f in range(num_functions):
+        lines.append(f"  sum = sum + f{f}({f}, 3);")
+    lines.append("  return 0;")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+def run(obelix: str, source: str, runs: int) -> tuple[list[float], dict | None]:
+    times = []
+    best_stats = None
+    stats_file = os.path.join(os.path.dirname(source), "stats.json")
+    for _ in range(runs):
+        if os.path.exists(stats_file):
+            os.unlink(stats_file)
+        start = time.perf_counter()
+        proc = subprocess.run([obelix, "--materialize", "--force", f"--stats-json={stats_file}", source],
+                              cwd=os.path.dirname(source), capture_output=True, text=True)
+        elapsed = time.perf_counter() - start
+        if proc.returncode != 0:
+            print(proc.stdout, proc.stderr, file=sys.stderr)
+            sys.exit(f"{obelix} failed with exit code {proc.returncode}")
+        if (not times or elapsed < min(times)) and os.path.exists(stats_file):
+            with open(stats_file) as f:
+                best_stats = json.load(f)
+        times.append(elapsed)
+    return times, best_stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Obelix front end throughput benchmark")
+    parser.add_argument("--functions", type=int, default=200)
+    parser.add_argument("--statements", type=int, default=25)
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("obelix", nargs="+")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, "bench.obl")
+        with open(source, "w") as f:
+            f.write(generate(args.functions, args.statements))
+        statements = args.functions * (args.statements + 1)
+        print(f"{args.functions} functions, {statements} statements, best of {args.runs} runs")
+        for obelix in args.obelix:
+            times, stats = run(obelix, source, args.runs)
+            best = min(times)
+            print(f"{obelix}: best {best:.3f}s, median {statistics.median(times):.3f}s, "
+                  f"{statements / best:.0f} statements/s")
+            for phase in (stats or {}).get("phases", []):
+                if phase["nodes"] > 0 and phase["seconds"] > 0:
+                    print(f"    {phase['phase']:<16} {phase['seconds']:8.3f}s {phase['nodes']:>10} nodes "
+                          f"{phase['nodes'] / phase['seconds']:>12.0f} nodes/s")
+
+
+if __name__ == "__main__":
+    main()
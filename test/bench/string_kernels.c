@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//
+// Compares the throughput of the vectorized string kernels of the runtime
+// with their scalar counterparts.
+//
+// Usage, from the root of the source tree:
+//   cc -O2 -Isrc/rt test/bench/string_kernels.c src/rt/strkernels.c -o string_kernels
+//   ./string_kernels [size in MB]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "strkernels.h"
+
+#define RUNS 10
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+static volatile uint64_t sink;
+
+#define BENCH(label, size, expr)                                       \
+    do {                                                               \
+        double best = 1e9;                                             \
+        for (int run = 0; run < RUNS; ++run) {                         \
+            double start = now();                                      \
+            sink += (uint64_t) (expr);                                 \
+            double elapsed = now() - start;                            \
+            if (elapsed < best)                                        \
+                best = elapsed;                                        \
+        }                                                              \
+        printf("    %-10s %8.3f ms %8.2f GB/s\n", label, best * 1000.0, \
+            (double) (size) / best / 1e9);                             \
+    } while (0)
+
+int main(int argc, char** argv)
+{
+    size_t size = ((argc > 1) ? (size_t) atol(argv[1]) : 64) * 1024 * 1024;
+    char* text = malloc(size + 1);
+    char* copy = malloc(size + 1);
+    if (!text || !copy) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // Lower case text without the needle, which is put at the very end.
+    srand(42);
+    for (size_t ix = 0; ix < size; ++ix)
+        text[ix] = (char) ('a' + rand() % 26);
+    char const* needle = "Obelix!";
+    size_t needle_len = strlen(needle);
+    memcpy(text + size - needle_len, needle, needle_len);
+    text[size] = '\0';
+    memcpy(copy, text, size + 1);
+
+    printf("%zu MB, kernels use %s\n", size / (1024 * 1024), str_kernel_isa());
+
+    printf("find\n");
+    BENCH("scalar", size, str_kernel_find_scalar(text, size, needle, needle_len));
+    BENCH("vector", size, str_kernel_find(text, size, needle, needle_len));
+
+    printf("compare\n");
+    BENCH("scalar", size, str_kernel_mismatch_scalar(text, copy, size));
+    BENCH("vector", size, str_kernel_mismatch(text, copy, size));
+
+    printf("cstrlen\n");
+    BENCH("scalar", size, str_kernel_strlen_scalar(text));
+    BENCH("vector", size, str_kernel_strlen(text));
+
+    free(text);
+    free(copy);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#  Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+#
+#  SPDX-License-Identifier: MIT
+
+#
+# Counts the string reference count updates of a string-heavy program,
+# compiled with and without --no-string-moves. The counts come from the
+# string pool statistics the runtime prints when OBELIX_INSPECT_STRING_POOLS
+# is set.
+#
+# Usage:
+#   python3 string_refcounts.py [--iterations N] obelix
+#
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+PROGRAM = """
+func decorate(prefix: string, s: string) : string
+{{
+  var ret = prefix + s;
+  return ret;
+}}
+
+func count_matches(haystack: string, needle: string) : s32
+{{
+  if (str_find(haystack, needle) >= 0) {{
+    return 1;
+  }}
+  return 0;
+}}
+
+func main() : s32
+{{
+  var word = "obelix";
+  var matches: s32 = 0;
+  var i: s32 = 0;
+  while (i < {iterations}) {{
+    var decorated = decorate("<", word);
+    var closed = decorate(decorated, ">");
+    matches = matches + count_matches(closed, word);
+    var last = closed;
+    if (length(last) > 100) {{
+      putln(last);
+    }}
+    ++i;
+  }}
+  puti(matches); putln("");
+  return 0;
+}}
+"""
+
+COUNTERS = {
+    "increments": re.compile(r"Total number of reference count increments: (\d+)"),
+    "decrements": re.compile(r"Total number of reference count decrements: (\d+)"),
+    "allocations": re.compile(r"Total number of strings allocated: (\d+)"),
+}
+
+
+def run(obelix: str, source: str, flags: list[str]) -> dict[str, int]:
+    workdir = os.path.dirname(source)
+    proc = subprocess.run([obelix, "--force"] + flags + [source], cwd=workdir, capture_output=True, text=True)
+    if proc.returncode != 0:
+        print(proc.stdout, proc.stderr, file=sys.stderr)
+        sys.exit(f"{obelix} failed with exit code {proc.returncode}")
+    env = dict(os.environ, OBELIX_INSPECT_STRING_POOLS="1")
+    proc = subprocess.run(["./bench"], cwd=workdir, capture_output=True, text=True, env=env)
+    counts = {}
+    for name, pattern in COUNTERS.items():
+        match = pattern.search(proc.stderr)
+        counts[name] = int(match.group(1)) if match else -1
+    return counts
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Obelix string reference count benchmark")
+    parser.add_argument("--iterations", type=int, default=100000)
+    parser.add_argument("obelix")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, "bench.obl")
+        with open(source, "w") as f:
+            f.write(PROGRAM.format(iterations=args.iterations))
+        print(f"{args.iterations} iterations")
+        for label, flags in (("copies", ["--no-string-moves"]), ("moves", [])):
+            counts = run(args.obelix, source, flags)
+            print(f"{label:<8} {counts['increments']:>10} increments {counts['decrements']:>10} decrements "
+                  f"{counts['allocations']:>10} strings allocated")
+
+
+if __name__ == "__main__":
+    main()
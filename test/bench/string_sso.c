@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//
+// Builds the kind of short strings programs and the compiler itself are
+// full of, identifiers, keywords and numbers, and reports how many of them
+// needed a heap allocation. The statistics come from str_inspect_pools.
+//
+// Usage, from the root of the source tree:
+//   cc -O2 -Isrc -Isrc/rt test/bench/string_sso.c src/rt/string.c src/rt/strkernels.c -o string_sso -lpthread
+//   ./string_sso [number of strings]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <rt/obelix.h>
+
+static char const* words[] = {
+    "id", "count", "result", "value_of", "transpile", "intrinsic_name", "identifier",
+    "BoundFunctionCall", "declared_type", "statements", "unresolved_references",
+};
+
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = (argc > 1) ? (size_t) atol(argv[1]) : 1000000;
+    string* strings = malloc(count * sizeof(string));
+    if (!strings) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    double start = now();
+    for (size_t ix = 0; ix < count; ++ix) {
+        switch (ix % 3) {
+        case 0:
+            strings[ix] = str_allocate(words[ix % WORD_COUNT]);
+            break;
+        case 1: {
+            string prefix = str_allocate(words[ix % WORD_COUNT]);
+            string suffix = to_string_u(ix, 10);
+            strings[ix] = str_concat(prefix, suffix);
+            str_free(prefix);
+            str_free(suffix);
+            break;
+        }
+        default:
+            strings[ix] = to_string_s(-(int64_t) ix * 7919, 10);
+            break;
+        }
+    }
+    for (size_t ix = 0; ix < count; ++ix)
+        str_free(strings[ix]);
+    double elapsed = now() - start;
+
+    printf("%zu strings in %.3f ms\n", count, elapsed * 1000.0);
+    str_inspect_pools();
+    free(strings);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#  Copyright (c) 2022, Jan de Visser <jan@finiandarcy.com>
+#
+#  SPDX-License-Identifier: MIT
+
+#
+# Measures the time the C transpiler takes to generate the C code for a
+# large generated module. This is the "generate C" phase in the compiler
+# statistics, so neither the front end nor the C compiler count.
+#
+# Usage:
+#   python3 transpile_time.py [--functions N] [--runs N] obelix [obelix ...]
+#
+# Passing more than one compiler executable compares them on the same
+# program.
+#
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from processor_throughput import generate
+
+
+def run(obelix: str, source: str) -> tuple[float, int]:
+    workdir = os.path.dirname(source)
+    stats_file = os.path.join(workdir, "stats.json")
+    proc = subprocess.run([obelix, "--force", "--keep-c-file", "--no-object-cache", f"--stats-json={stats_file}", source],
+                          cwd=workdir, capture_output=True, text=True)
+    if proc.returncode != 0:
+        print(proc.stdout, proc.stderr, file=sys.stderr)
+        sys.exit(f"{obelix} failed with exit code {proc.returncode}")
+    size = sum(os.path.getsize(f) for f in glob.glob(os.path.join(workdir, ".obelix", "*.[ch]")))
+    with open(stats_file) as f:
+        stats = json.load(f)
+    seconds = sum(phase["seconds"] for phase in stats.get("phases", []) if phase["phase"] == "generate C")
+    return seconds, size
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Obelix C transpiler benchmark")
+    parser.add_argument("--functions", type=int, default=2000)
+    parser.add_argument("--statements", type=int, default=25)
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("obelix", nargs="+")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, "bench.obl")
+        with open(source, "w") as f:
+            f.write(generate(args.functions, args.statements))
+        print(f"{args.functions} functions, {args.functions * (args.statements + 1)} statements, "
+              f"best of {args.runs} runs")
+        for obelix in args.obelix:
+            results = [run(obelix, source) for _ in range(args.runs)]
+            seconds = min(r[0] for r in results)
+            size = results[0][1]
+            print(f"{obelix:<40} generate C {seconds:.3f}s, {size} bytes of C, {size / seconds / 1e6:.1f} MB/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -11,6 +11,9 @@ import subprocess
 
 import sys
 
+# Extra command line flags passed to the compiler for every test
+obelix_flags = []
+
 
 def check_stream(script, which, stream):
     ret = 0
@@ -42,7 +45,7 @@ def compile_script(name):
             os.remove(name)
         if os.path.exists(os.path.join(".compiled", name)):
             os.remove(os.path.join(".compiled", name))
-        ex = subprocess.call(["../build/bin/obelix", "--keep-assembly", f], stdout=out, stderr=err)
+        ex = subprocess.call(["../build/bin/obelix", "--keep-assembly"] + obelix_flags + [f], stdout=out, stderr=err)
         if ex != 0:
             print(f"Compilation of '{f}' failed: {ex}")
             subprocess.call(["cat", "stdout"])
@@ -204,7 +207,12 @@ group.add_argument(
 group.add_argument(
     "--nuke", action='store_true',
     help="Clear the test registry. The expected outcome .json files will be deleted as well")
+arg_parser.add_argument(
+    "--in-process-cc", action='store_true',
+    help="Compile the tests with the in-process C compiler. Faster, but the tests are not optimized like release builds")
 args = arg_parser.parse_args()
+if args.in_process_cc:
+    obelix_flags.append("--in-process-cc")
 
 if args.execute_all:
     run_all_tests()